@@ -42,6 +42,8 @@ simple_format_config::simple_format_config(const string& file) {
         _scope = scope_none;
     } else if (in_scope == "singleton") {
         _scope = scope_singleton;
+    } else if (in_scope == "pooled") {
+        _scope = scope_pooled;
     } else {
         throw runtime_error(in_scope);
     }
@@ -33,6 +33,8 @@ using namespace inject;
 template<class T>
 struct MyAllocator {
 
+    typedef T value_type;
+
     template<class U>
     struct rebind {
         typedef MyAllocator<U> other;
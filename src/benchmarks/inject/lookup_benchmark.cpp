@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * measures the latency of context::instance() - resolving components bound in
+ * the outermost of a stack of nested contexts, from the innermost one
+ *
+ * build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers
+ */
+
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "inject/inject.h"
+
+#if __cplusplus >= 201103L
+#include <random>
+#endif
+
+using namespace inject;
+using namespace std;
+
+/** number of resolutions timed for each configuration */
+const size_t LOOKUPS = 4000000;
+
+/** number of components bound, and resolved in turn */
+const int COMPONENTS = 64;
+
+/** keeps the optimizer from dropping the resolutions */
+volatile size_t sink = 0;
+
+template<int N>
+class bench_component {
+public:
+    virtual ~bench_component() { }
+};
+
+typedef size_t (*resolver)(context<>& c);
+
+template<int N>
+size_t resolve(context<>& c) {
+    return c.instance< bench_component<N> >().get() != 0 ? 1 : 0;
+}
+
+/** declares components 1..N, for as long as it lives */
+template<int N>
+struct components {
+    typedef bench_component<N> type;
+
+    context<>::component<type> declared;
+    typename context<>::component<type>::template provides<type> provided;
+    components<N - 1> rest;
+
+    template<component_scope Scope>
+    static void bind(context<>& c) {
+        c.bind<type, Scope>();
+        components<N - 1>::template bind<Scope>(c);
+    }
+
+    static void list(vector<resolver>& resolvers) {
+        resolvers.push_back(&resolve<N>);
+        components<N - 1>::list(resolvers);
+    }
+};
+
+template<>
+struct components<0> {
+    template<component_scope Scope>
+    static void bind(context<>&) { }
+
+    static void list(vector<resolver>&) { }
+};
+
+double nanos_per_lookup(context<>& c, const vector<resolver>& resolvers) {
+    size_t found = 0;
+
+    // the first resolutions compile the plans (and activate the singletons)
+    for (size_t i = 0 ; i < resolvers.size() ; ++i) {
+        found += resolvers[i](c);
+    }
+
+    clock_t start = clock();
+    for (size_t i = 0 ; i < LOOKUPS ; ++i) {
+        found += resolvers[i % resolvers.size()](c);
+    }
+    clock_t end = clock();
+
+    sink = sink + found;
+
+    return (double)(end - start) * 1e9 / CLOCKS_PER_SEC / LOOKUPS;
+}
+
+void shuffle_resolvers(vector<resolver>& resolvers) {
+#if __cplusplus >= 201103L
+    std::shuffle(resolvers.begin(), resolvers.end(), std::mt19937(42));
+#else
+    // fisher-yates, with a linear congruential generator
+    unsigned long state = 42;
+    for (size_t i = resolvers.size() ; i > 1 ; --i) {
+        state = state * 1103515245UL + 12345UL;
+        swap(resolvers[i - 1], resolvers[(state >> 16) % i]);
+    }
+#endif
+}
+
+/** times resolutions from a context nested <code>depth</code> levels deep */
+double nested(int depth, const vector<resolver>& resolvers) {
+    context<> c;
+    return depth > 1 ?
+        nested(depth - 1, resolvers) :
+        nanos_per_lookup(c, resolvers);
+}
+
+template<component_scope Scope>
+double run(int depth, const vector<resolver>& resolvers) {
+    context<> outermost;
+    components<COMPONENTS>::bind<Scope>(outermost);
+    return nested(depth, resolvers);
+}
+
+void run(int depth, const vector<resolver>& resolvers) {
+    cout <<
+        setw(8) << depth <<
+        setw(20) << fixed << setprecision(1) <<
+        run<scope_singleton>(depth, resolvers) <<
+        setw(20) << run<scope_none>(depth, resolvers) <<
+        endl;
+}
+
+int main() {
+    components<COMPONENTS> declared;
+
+    // resolve components in random order, like a resolve-heavy application.
+    // the seed is fixed, so runs are comparable
+    vector<resolver> resolvers;
+    components<COMPONENTS>::list(resolvers);
+    shuffle_resolvers(resolvers);
+
+    cout <<
+        setw(8) << "depth" <<
+        setw(20) << "singleton (ns)" <<
+        setw(20) << "scope_none (ns)" <<
+        endl;
+
+    run(1, resolvers);
+    run(4, resolvers);
+    run(16, resolvers);
+
+    return 0;
+}
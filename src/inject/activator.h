@@ -28,8 +28,11 @@
 namespace inject {
 
 /**
- * allocates an instance using the given allocator.this should probably be the
- * first activator called in the construction chain.
+ * allocates and owns instances using the given allocator. this is the first
+ * stage of an instance's activation.
+ *
+ * an instance is allocated along with the reference count of the pointers to
+ * it, in a single allocation - see the context's pointer policy.
  *
  * @tparam ID context ID
  * @tparam Allocator allocator to use - should behave like
@@ -38,19 +41,192 @@ namespace inject {
  */
 template<int ID>
 template<class Allocator, class Activated>
-class context<ID>::allocator_activator : public generic_activator {
+class context<ID>::allocator_activator {
+private:
+    typedef typename rebind_allocator<Allocator, Activated>::type AL;
+
+    typedef typename pointer_policy::template storage<Allocator, Activated>
+        storage;
+
+    /**
+     * bookkeeping of a block, in front of its instances. the block also holds
+     * the reference counts of the pointers to its instances, so it's a single
+     * allocation - the memory is given back once every one of them is
+     */
+    struct block_header {
+        /** reference counts not yet deallocated, or never handed out */
+        atomic<std::size_t> references;
+
+        /** length of the block, in units */
+        std::size_t units;
+
+        /** reference counts the block has room for */
+        std::size_t counts;
+
+        /** reference counts handed out */
+        std::size_t used;
+
+        /** the first reference count */
+        char* first;
+
+        block_header(std::size_t units, std::size_t counts, char* first) :
+            references(counts),
+            units(units),
+            counts(counts),
+            used(0),
+            first(first) { }
+    };
+
+    /** alignment of a block - its header, then its instances */
+    enum {
+        block_alignment =
+            boost::alignment_of<Activated>::value >
+                boost::alignment_of<block_header>::value ?
+            boost::alignment_of<Activated>::value :
+            boost::alignment_of<block_header>::value
+    };
+
+    /** what blocks are allocated in */
+    typedef typename boost::aligned_storage<
+        block_alignment, block_alignment>::type block_unit;
+
+    typedef typename rebind_allocator<Allocator, block_unit>::type UL;
+
+    /** offset of the first instance in a block */
+    static const std::size_t block_instances =
+        (sizeof(block_header) + boost::alignment_of<Activated>::value - 1) /
+            boost::alignment_of<Activated>::value *
+            boost::alignment_of<Activated>::value;
+
+    /**
+     * hands out the reference counts of a block's pointers from the block
+     * itself - or, without a block, measures them (using
+     * <code>std::allocator</code>, so Allocator only ever sees blocks)
+     */
+    template<class U>
+    class block_allocator {
+    public:
+        typedef U value_type;
+
+        template<class V>
+        struct rebind {
+            typedef block_allocator<V> other;
+        };
+
+        /** block to hand out from */
+        block_header* block;
+
+        /** where to measure to, without a block */
+        std::size_t* measured;
+
+        block_allocator(block_header* block, std::size_t* measured = 0) :
+            block(block),
+            measured(measured) { }
+
+        template<class V>
+        block_allocator(const block_allocator<V>& other) :
+            block(other.block),
+            measured(other.measured) { }
+
+        U* allocate(std::size_t n) {
+            if (block == 0) {
+                if (measured != 0) {
+                    *measured = (sizeof(U) + block_alignment - 1) /
+                        block_alignment * block_alignment;
+                }
+
+                return std::allocator<U>().allocate(n);
+            }
+
+            assert(n == 1 && block->used < block->counts);
+            assert(boost::alignment_of<U>::value <= block_alignment);
+            return reinterpret_cast<U*>(
+                block->first + block->used++ * count_size());
+        }
+
+        void deallocate(U* p, std::size_t n) {
+            if (block == 0) {
+                std::allocator<U>().deallocate(p, n);
+                return;
+            }
+
+            release(block, 1);
+        }
+    };
+
+    /**
+     * destroys an instance in a block - or, for the pointer owning the block
+     * itself, releases the reference counts it didn't hand out
+     */
+    class block_deleter {
+    private:
+        block_header* _block;
+    public:
+        /** @param block block owned, <code>0</code> for an instance */
+        explicit block_deleter(block_header* block) throw() : _block(block) { }
+
+        void operator()(Activated* instance) {
+            if (_block != 0) {
+                release(_block, _block->counts - _block->used);
+            } else if (instance != 0) {
+                instance->~Activated();
+            }
+        }
+    };
+
+    /** @return room taken by a reference count of a block's pointers */
+    static std::size_t count_size();
+    static std::size_t measure_count();
+
+    /**
+     * gives back <code>n</code> of a block's reference counts, and the block
+     * with the last of them
+     */
+    static void release(block_header* block, std::size_t n);
 public:
-    allocator_activator() : generic_activator() { }
-    virtual ~allocator_activator() { }
+    /** @return functions to store in the component's descriptor */
+    static allocator_functions functions();
+private:
+    /** sets the block functions, if the context's pointers allow them */
+    static void block_functions(allocator_functions& f, boost::true_type);
+    static void block_functions(allocator_functions& f, boost::false_type);
 public:
+
     /**
-     * allocates a new instance of Activated using Allocator, and returns a
-     * pointer to it.
-     *
-     * @param instance ignored
-     * @return pointer to allocated, uninitialized, instance
+     * allocates a new instance of Activated, and the reference count of the
+     * pointers to it, in a single allocation using Allocator
+     * @return pointer to allocated, uninitialized, instance. releasing it
+     *         deallocates the instance, and destroys it once it's adopted
      */
-    context<ID>::unknown_ptr activate(context<ID>::unknown_ptr instance);
+    static unknown_ptr allocate();
+
+    /**
+     * @param instance constructed instance, returned by <code>allocate()</code>
+     */
+    static void adopt(void* instance);
+
+    /**
+     * allocates a block of instances of Activated, and the reference counts of
+     * the pointers to them, in a single allocation using Allocator
+     * @param n number of instances
+     * @return pointer owning the allocated, uninitialized, instances
+     */
+    static unknown_ptr allocate_block(std::size_t n);
+
+    /**
+     * @param instance allocated and constructed instance, inside
+     *        <code>block</code>
+     * @param block block returned by <code>allocate_block()</code>
+     * @return pointer owning the instance, which will destroy it and release
+     *         its hold on the block. doesn't allocate
+     */
+    static unknown_ptr adopt_in_block(void* instance, const unknown_ptr& block);
+
+    /**
+     * destroys an instance without deallocating it
+     * @param instance constructed instance
+     */
+    static void destroy(void* instance);
 };
 
 /**
@@ -60,17 +236,14 @@ public:
  */
 template<int ID>
 template<class Activated>
-class context<ID>::default_constructor_activator : public generic_activator {
-public:
-    default_constructor_activator() : generic_activator() { }
-    virtual ~default_constructor_activator() { }
+class context<ID>::default_constructor_activator {
 public:
     /**
      * @param instance an allocated, uninitialized pointer to an
-     *        <code>Activated</code> instance
-     * @return given instance, after initialization using default constructor
+     *        <code>Activated</code> instance, initialized using default
+     *        constructor
      */
-    context<ID>::unknown_ptr activate(context<ID>::unknown_ptr instance);
+    static void activate(void* instance);
 };
 
 /**
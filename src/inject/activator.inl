@@ -25,27 +25,137 @@
 
 namespace inject {
 
+template<int ID>
+template<class Allocator, class Activated>
+typename context<ID>::allocator_functions
+context<ID>::allocator_activator<Allocator, Activated>::functions() {
+    allocator_functions f;
+    f.allocate = &allocate;
+    f.adopt = &adopt;
+    block_functions(f, custom_ownership());
+    f.destroy = &destroy;
+    f.instance_size = sizeof(Activated);
+    f.instance_alignment = boost::alignment_of<Activated>::value;
+    return f;
+}
+
+template<int ID>
+template<class Allocator, class Activated>
+typename context<ID>::unknown_ptr
+context<ID>::allocator_activator<Allocator, Activated>::allocate() {
+    return storage::allocate();
+}
+
+template<int ID>
+template<class Allocator, class Activated>
+void context<ID>::allocator_activator<Allocator, Activated>::
+adopt(void* instance) {
+    storage::adopt(instance);
+}
+
+template<int ID>
+template<class Allocator, class Activated>
+void context<ID>::allocator_activator<Allocator, Activated>::
+block_functions(allocator_functions& f, boost::true_type) {
+    f.allocate_block = &allocate_block;
+    f.adopt_in_block = &adopt_in_block;
+}
+
+template<int ID>
+template<class Allocator, class Activated>
+void context<ID>::allocator_activator<Allocator, Activated>::
+block_functions(allocator_functions&, boost::false_type) {
+    // blocks are owned through deleters - instantiate one at a time
+}
+
+template<int ID>
+template<class Allocator, class Activated>
+std::size_t
+context<ID>::allocator_activator<Allocator, Activated>::count_size() {
+    static const std::size_t size = measure_count();
+    return size;
+}
+
+template<int ID>
+template<class Allocator, class Activated>
+std::size_t
+context<ID>::allocator_activator<Allocator, Activated>::measure_count() {
+    // the reference count's type is the pointer's own business - have one
+    // allocated to find out
+    std::size_t measured = 0;
+    {
+        unknown_ptr p(static_cast<Activated*>(0), block_deleter(0),
+            block_allocator<Activated>(0, &measured));
+    }
+    return measured;
+}
+
+template<int ID>
+template<class Allocator, class Activated>
+void context<ID>::allocator_activator<Allocator, Activated>::
+release(block_header* block, std::size_t n) {
+    if (n == 0 || block->references.fetch_sub(n) != n) {
+        return;
+    }
+
+    std::size_t units = block->units;
+    block->~block_header();
+
+    UL ul;
+    ul.deallocate(reinterpret_cast<block_unit*>(block), units);
+}
+
 template<int ID>
 template<class Allocator, class Activated>
 typename context<ID>::unknown_ptr
 context<ID>::allocator_activator<Allocator, Activated>::
-activate(unknown_ptr instance) {
-    typedef typename Allocator::template rebind<Activated>::other AL;
-    AL al;
+allocate_block(std::size_t n) {
+    // header, instances, then a reference count for each of them and one for
+    // the block's own pointer
+    std::size_t counts_offset =
+        (block_instances + n * sizeof(Activated) + block_alignment - 1) /
+            block_alignment * block_alignment;
+    std::size_t size = counts_offset + (n + 1) * count_size();
+    std::size_t units = (size + sizeof(block_unit) - 1) / sizeof(block_unit);
+
+    UL ul;
+    char* memory = reinterpret_cast<char*>(ul.allocate(units));
+    block_header* block =
+        new(memory) block_header(units, n + 1, memory + counts_offset);
 
+    // handing out the reference count can't throw
     return context<ID>::unknown_ptr(
-        al.allocate(1),
-        allocator_deleter<AL, Activated>(al));
+        reinterpret_cast<Activated*>(memory + block_instances),
+        block_deleter(block),
+        block_allocator<Activated>(block));
 }
 
 template<int ID>
-template<class Activated>
+template<class Allocator, class Activated>
 typename context<ID>::unknown_ptr
-context<ID>::default_constructor_activator<Activated>::
-activate(unknown_ptr instance) {
-    Activated* activated = reinterpret_cast<Activated*>(instance.get());
-    new(activated) Activated();
-    return instance;
+context<ID>::allocator_activator<Allocator, Activated>::
+adopt_in_block(void* instance, const unknown_ptr& block) {
+    block_header* header = reinterpret_cast<block_header*>(
+        static_cast<char*>(block.get()) - block_instances);
+
+    return context<ID>::unknown_ptr(
+        static_cast<Activated*>(instance),
+        block_deleter(0),
+        block_allocator<Activated>(header));
+}
+
+template<int ID>
+template<class Allocator, class Activated>
+void context<ID>::allocator_activator<Allocator, Activated>::
+destroy(void* instance) {
+    static_cast<Activated*>(instance)->~Activated();
+}
+
+template<int ID>
+template<class Activated>
+void context<ID>::default_constructor_activator<Activated>::
+activate(void* instance) {
+    new(instance) Activated();
 }
 
 } // namespace inject
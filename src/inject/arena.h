@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_ARENA_H__
+#define __INJECT_ARENA_H__
+
+#include "context.h"
+
+namespace inject {
+
+/**
+ * monotonic storage of the instances created by an arena context. instances
+ * (and the control blocks of the pointers to them) are bump-allocated from
+ * chunks owned by the arena. releasing a pointer does nothing - instead, when
+ * the arena is destroyed, all instances are destroyed in reverse creation
+ * order and the chunks are freed at once.
+ *
+ * @tparam ID context ID
+ */
+template<int ID>
+class context<ID>::instance_arena {
+public:
+    /** destroys an instance, without deallocating it */
+    typedef void (*destroy_function)(void* instance);
+
+    struct destructor;
+private:
+    struct chunk;
+
+    template<class U>
+    class block_allocator;
+
+    /** deleter of pointers to arena instances - they're destroyed later */
+    struct null_deleter {
+        void operator()(void*) const { }
+    };
+
+    /** size of the first chunk - each chunk is twice the size of the last */
+    static const std::size_t initial_chunk_size = 4096;
+private:
+    /** the chunk allocations are made from */
+    chunk* _chunk;
+
+    /** next free byte in <code>_chunk</code> */
+    char* _next;
+
+    /** end of <code>_chunk</code> */
+    char* _end;
+
+    /** destructor of the most recently created instance */
+    destructor* _last;
+private: // non-copyable
+    instance_arena(const instance_arena&);
+    instance_arena& operator=(const instance_arena&);
+public:
+    instance_arena();
+
+    /** destroys the instances in reverse creation order, frees the memory */
+    ~instance_arena();
+
+    /**
+     * @param size bytes to allocate
+     * @param alignment required alignment, a power of two
+     * @return uninitialized memory, freed with the arena
+     */
+    void* allocate(std::size_t size, std::size_t alignment);
+
+    /**
+     * reserves the destruction record of an instance, before constructing it
+     * - so adopting the constructed instance doesn't need to allocate it
+     * @return uninitialized record, freed with the arena
+     */
+    destructor* reserve();
+
+    /**
+     * @param instance constructed instance, allocated from the arena
+     * @param destroy destroys <code>instance</code>
+     * @param reserved record returned by <code>reserve()</code>
+     * @return pointer to the instance, which doesn't own it - the instance is
+     *         destroyed with the arena (even if this throws)
+     */
+    unknown_ptr adopt(void* instance, destroy_function destroy,
+        destructor* reserved);
+};
+
+/**
+ * a chunk of arena memory - the usable memory follows the header
+ */
+template<int ID>
+struct context<ID>::instance_arena::chunk {
+    chunk* prev;
+    std::size_t size;
+};
+
+/**
+ * a pending destruction of an arena instance
+ */
+template<int ID>
+struct context<ID>::instance_arena::destructor {
+    void* instance;
+    destroy_function destroy;
+    destructor* prev;
+};
+
+/**
+ * allocates the control blocks of pointers to arena instances from the arena
+ *
+ * @tparam U allocated type
+ */
+template<int ID>
+template<class U>
+class context<ID>::instance_arena::block_allocator {
+public:
+    typedef U value_type;
+    typedef U* pointer;
+    typedef const U* const_pointer;
+    typedef U& reference;
+    typedef const U& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<class V>
+    struct rebind {
+        typedef block_allocator<V> other;
+    };
+private:
+    instance_arena* _arena;
+public:
+    explicit block_allocator(instance_arena* arena) : _arena(arena) { }
+
+    template<class V>
+    block_allocator(const block_allocator<V>& other) : _arena(other.arena()) { }
+
+    /** @return the arena blocks are allocated from */
+    instance_arena* arena() const { return _arena; }
+
+    U* allocate(std::size_t n, const void* = 0) {
+        return static_cast<U*>(_arena->allocate(sizeof(U) * n,
+            boost::alignment_of<U>::value));
+    }
+
+    void deallocate(U*, std::size_t) {
+        // freed with the arena
+    }
+
+    void construct(U* p, const U& value) { new(p) U(value); }
+    void destroy(U* p) { p->~U(); }
+
+    std::size_t max_size() const throw() { return std::size_t(-1) / sizeof(U); }
+
+    template<class V>
+    bool operator==(const block_allocator<V>& other) const {
+        return _arena == other.arena();
+    }
+
+    template<class V>
+    bool operator!=(const block_allocator<V>& other) const {
+        return _arena != other.arena();
+    }
+};
+
+} // namespace inject
+
+#include "arena.inl"
+
+#endif // __INJECT_ARENA_H__
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_ARENA_INL__
+#define __INJECT_ARENA_INL__
+
+namespace inject {
+
+template<int ID>
+context<ID>::instance_arena::instance_arena() :
+    _chunk(0),
+    _next(0),
+    _end(0),
+    _last(0) {
+}
+
+template<int ID>
+context<ID>::instance_arena::~instance_arena() {
+    for (destructor* d = _last ; d != 0 ; d = d->prev) {
+        d->destroy(d->instance);
+    }
+
+    while (_chunk != 0) {
+        chunk* prev = _chunk->prev;
+        ::operator delete(_chunk);
+        _chunk = prev;
+    }
+}
+
+template<int ID>
+void* context<ID>::instance_arena::allocate(std::size_t size,
+        std::size_t alignment) {
+    std::size_t padding = static_cast<std::size_t>(
+        -reinterpret_cast<std::ptrdiff_t>(_next)) & (alignment - 1);
+
+    if (_chunk == 0 ||
+            padding + size > static_cast<std::size_t>(_end - _next)) {
+        std::size_t chunk_size = _chunk != 0 ?
+            _chunk->size * 2 : initial_chunk_size;
+        while (chunk_size < sizeof(chunk) + size + alignment) {
+            chunk_size *= 2;
+        }
+
+        chunk* c = static_cast<chunk*>(::operator new(chunk_size));
+        c->prev = _chunk;
+        c->size = chunk_size;
+
+        _chunk = c;
+        _next = reinterpret_cast<char*>(c + 1);
+        _end = reinterpret_cast<char*>(c) + chunk_size;
+
+        padding = static_cast<std::size_t>(
+            -reinterpret_cast<std::ptrdiff_t>(_next)) & (alignment - 1);
+    }
+
+    void* p = _next + padding;
+    _next += padding + size;
+    return p;
+}
+
+template<int ID>
+typename context<ID>::instance_arena::destructor*
+context<ID>::instance_arena::reserve() {
+    return static_cast<destructor*>(allocate(sizeof(destructor),
+        boost::alignment_of<destructor>::value));
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::instance_arena::adopt(void* instance, destroy_function destroy,
+        destructor* reserved) {
+    destructor* d = reserved;
+    d->instance = instance;
+    d->destroy = destroy;
+    d->prev = _last;
+    _last = d;
+
+    return unknown_ptr(instance, null_deleter(), block_allocator<char>(this));
+}
+
+} // namespace inject
+
+#endif // __INJECT_ARENA_INL__
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_ASYNC_H__
+#define __INJECT_ASYNC_H__
+
+#include "context.h"
+#include "executor.h"
+
+#ifdef INJECT_HAS_STD_THREADS
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace inject {
+
+template<int ID>
+template<class Interface>
+std::future<typename context<ID>::template ptr<Interface>::type>
+context<ID>::instance_async() {
+    typedef typename ptr<Interface>::type ptr_type;
+
+    std::shared_ptr< std::packaged_task<ptr_type()> > resolving =
+        std::make_shared< std::packaged_task<ptr_type()> >([this] {
+            return pointer_policy::template typed<Interface>(
+                instance_prepared(id_of<Interface>::id()));
+        });
+    std::future<ptr_type> result = resolving->get_future();
+
+    executor::shared().submit<void>([resolving] { (*resolving)(); });
+    return result;
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::instance_prepared(unique_id interface_id) {
+    component_descriptor* plan_descriptor;
+    component_scope scope;
+
+    {
+        // the plan may be replaced once we're done reading it
+        epoch_guard reading;
+        resolution_plan& p = plan(interface_id);
+
+        plan_descriptor = p.descriptor;
+        scope = p.scope;
+    }
+
+    prepared_arguments args;
+    args.component_id = plan_descriptor->id;
+    args.interfaces = plan_descriptor->constructor_dependencies;
+
+    if (scope != scope_none || args.interfaces.empty()) {
+        // shared instances are only constructed once, if at all
+        return instance(interface_id);
+    }
+
+    args.instances.resize(args.interfaces.size());
+
+    // each interface is resolved as a job of its own, for all arguments of it
+    // - the last one on this thread
+    std::vector<unique_id> distinct;
+    for (std::size_t i = 0 ; i < args.interfaces.size() ; ++i) {
+        if (std::find(distinct.begin(), distinct.end(), args.interfaces[i]) ==
+                distinct.end()) {
+            distinct.push_back(args.interfaces[i]);
+        }
+    }
+
+    auto resolve_all = [this, &args] (unique_id id) {
+        for (std::size_t i = 0 ; i < args.interfaces.size() ; ++i) {
+            if (args.interfaces[i] == id) {
+                args.instances[i] = instance(id);
+            }
+        }
+    };
+
+    std::exception_ptr failure;
+    if (_arena) {
+        // the arena isn't shared between threads
+        try {
+            for (std::size_t i = 0 ; i < distinct.size() ; ++i) {
+                resolve_all(distinct[i]);
+            }
+        } catch (...) {
+            failure = std::current_exception();
+        }
+    } else {
+        // the jobs refer to this frame, so once one is submitted every one of
+        // them is waited for before leaving, even if a later submit throws
+        std::vector< executor::ticket<void> > resolving;
+        resolving.reserve(distinct.size() - 1);
+        try {
+            for (std::size_t i = 0 ; i + 1 < distinct.size() ; ++i) {
+                unique_id id = distinct[i];
+                resolving.push_back(executor::shared().submit<void>(
+                    [&resolve_all, id] { resolve_all(id); }));
+            }
+
+            resolve_all(distinct.back());
+        } catch (...) {
+            failure = std::current_exception();
+        }
+
+        for (std::size_t i = 0 ; i < resolving.size() ; ++i) {
+            try {
+                resolving[i].get();
+            } catch (...) {
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+            }
+        }
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    // the constructor takes the arguments as its first resolution
+    prepared() = &args;
+    try {
+        unknown_ptr instance = this->instance(interface_id);
+        prepared() = 0;
+        return instance;
+    } catch (...) {
+        prepared() = 0;
+        throw;
+    }
+}
+
+#ifdef INJECT_HAS_COROUTINES
+template<int ID>
+template<class Interface>
+task<typename context<ID>::template ptr<Interface>::type>
+context<ID>::co_instance() {
+    co_return pointer_policy::template typed<Interface>(
+        co_await co_resolve(id_of<Interface>::id()));
+}
+
+template<int ID>
+task<typename context<ID>::unknown_ptr>
+context<ID>::co_resolve(unique_id interface_id,
+        const co_resolution* dependent) {
+    component_descriptor* plan_descriptor;
+    component_scope scope;
+
+    {
+        // the plan may be replaced once we're done reading it
+        epoch_guard reading;
+        resolution_plan& p = plan(interface_id);
+
+        plan_descriptor = p.descriptor;
+        scope = p.scope;
+    }
+
+    if (scope != scope_none) {
+        // shared instances are initialized once, for everyone waiting
+        co_return instance(interface_id);
+    }
+
+    // the arguments are still being awaited, so no activation guards them
+    for (const co_resolution* r = dependent ; r != 0 ; r = r->dependent) {
+        if (r->component_id == plan_descriptor->id) {
+            throw circular_dependency(plan_descriptor->id);
+        }
+    }
+
+    co_resolution resolution = { plan_descriptor->id, dependent };
+
+    prepared_arguments args;
+    args.component_id = plan_descriptor->id;
+    args.interfaces = plan_descriptor->constructor_dependencies;
+    args.instances.resize(args.interfaces.size());
+
+    // every argument is started before any is awaited - the ones that are
+    // still initializing when it's their turn resume this coroutine later
+    std::vector< task<unknown_ptr> > resolving;
+    for (std::size_t i = 0 ; i < args.interfaces.size() ; ++i) {
+        resolving.push_back(co_resolve(args.interfaces[i], &resolution));
+    }
+
+    // all of them are awaited even if one fails, so none is left running
+    std::exception_ptr failure;
+    for (std::size_t i = 0 ; i < resolving.size() ; ++i) {
+        try {
+            args.instances[i] = co_await resolving[i];
+        } catch (...) {
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    // the constructor takes the arguments as its first resolution, and the
+    // activation hands over the initialization instead of blocking on it
+    deferred_initialization deferral;
+    deferral.component_id = plan_descriptor->id;
+
+    prepared() = args.instances.empty() ? 0 : &args;
+    deferred() = &deferral;
+
+    unknown_ptr instance;
+    try {
+        instance = this->instance(interface_id);
+    } catch (...) {
+        failure = std::current_exception();
+    }
+
+    prepared() = 0;
+    deferred() = 0;
+
+    if (deferral.initialization.valid()) {
+        // the instance may have been initializing when the resolution failed
+        try {
+            co_await deferral.initialization;
+        } catch (...) {
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    co_return instance;
+}
+#endif
+
+} // namespace inject
+
+#endif // INJECT_HAS_STD_THREADS
+
+#endif // __INJECT_ASYNC_H__
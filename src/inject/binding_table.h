@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_BINDING_TABLE_H__
+#define __INJECT_BINDING_TABLE_H__
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "id_of.h"
+#include "binding.h"
+
+namespace inject {
+
+/**
+ * a table of bindings, indexed by the bound component's id
+ *
+ * the table is split into fixed-size chunks, which are shared between tables
+ * and copied only when written to. this allows a context to keep a flattened
+ * view of all the bindings in effect (its own, and the ones it inherits from
+ * its parents), where a lookup is a single probe regardless of nesting depth,
+ * while a nested context that overrides a few bindings shares everything
+ * else with its parent.
+ */
+class binding_table {
+private: // types
+    enum {
+        chunk_bits = 6,
+        chunk_size = 1 << chunk_bits
+    };
+
+    struct chunk {
+        binding entries[chunk_size];
+    };
+
+    typedef boost::shared_ptr<chunk> chunk_ptr;
+    typedef std::vector<chunk_ptr> chunks_vector;
+private: // members
+    chunks_vector _chunks;
+public: // methods
+    /**
+     * @param id id of bound component
+     * @return binding of the given component, or <code>0</code> if there is
+     *         none
+     */
+    const binding* find(unique_id id) const {
+        std::size_t index = static_cast<std::size_t>(id);
+        std::size_t c = index >> chunk_bits;
+
+        if (c >= _chunks.size() || _chunks[c].get() == 0) {
+            return 0;
+        }
+
+        const binding& b = _chunks[c]->entries[index & (chunk_size - 1)];
+        return b.what() != INVALID_ID ? &b : 0;
+    }
+
+    /**
+     * adds a binding, replacing any existing binding of the same component
+     * @param b binding to add
+     */
+    void set(const binding& b) {
+        std::size_t index = static_cast<std::size_t>(b.what());
+        writable(index >> chunk_bits).entries[index & (chunk_size - 1)] = b;
+    }
+
+    /**
+     * adds all bindings of another table, replacing existing bindings of the
+     * same components. chunks which don't exist in this table are shared, not
+     * copied.
+     * @param other table to add bindings of
+     */
+    void override_with(const binding_table& other) {
+        if (_chunks.size() < other._chunks.size()) {
+            _chunks.resize(other._chunks.size());
+        }
+
+        for (std::size_t c = 0 ; c < other._chunks.size() ; ++c) {
+            const chunk_ptr& theirs = other._chunks[c];
+
+            if (theirs.get() == 0) {
+                continue;
+            }
+
+            if (_chunks[c].get() == 0) {
+                _chunks[c] = theirs;
+                continue;
+            }
+
+            chunk& mine = writable(c);
+            for (std::size_t i = 0 ; i < chunk_size ; ++i) {
+                if (theirs->entries[i].what() != INVALID_ID) {
+                    mine.entries[i] = theirs->entries[i];
+                }
+            }
+        }
+    }
+
+    /**
+     * @param out receives all bindings of this table, ordered by the bound
+     *        component's id
+     */
+    void copy_to(std::vector<binding>& out) const {
+        for (std::size_t c = 0 ; c < _chunks.size() ; ++c) {
+            if (_chunks[c].get() == 0) {
+                continue;
+            }
+
+            for (std::size_t i = 0 ; i < chunk_size ; ++i) {
+                if (_chunks[c]->entries[i].what() != INVALID_ID) {
+                    out.push_back(_chunks[c]->entries[i]);
+                }
+            }
+        }
+    }
+
+    /** removes all bindings */
+    void clear() {
+        _chunks.clear();
+    }
+private:
+    /**
+     * @param c chunk index
+     * @return chunk, allocated or copied if it is shared with another table
+     */
+    chunk& writable(std::size_t c) {
+        if (c >= _chunks.size()) {
+            _chunks.resize(c + 1);
+        }
+
+        chunk_ptr& p = _chunks[c];
+        if (p.get() == 0) {
+            p.reset(new chunk());
+        } else if (!p.unique()) {
+            p.reset(new chunk(*p));
+        }
+
+        return *p;
+    }
+};
+
+} // namespace inject
+
+#endif // __INJECT_BINDING_TABLE_H__
@@ -152,12 +152,96 @@ public:
     template<class Allocator>
     class allocator {
     private:
-        generic_activator* _prev_activator;
+        allocator_functions _prev_allocator;
     public:
         allocator();
         virtual ~allocator();
     };
 
+    /**
+     * sets the number of idle instances kept for <code>scope_pooled</code>
+     * bindings of the current component (16 unless declared)
+     *
+     * @tparam Capacity maximal number of idle instances
+     */
+    template<std::size_t Capacity>
+    class pooled {
+    private:
+        std::size_t _prev_capacity;
+    public:
+        pooled() {
+            component_descriptor& desc = registry()[id_of<T>::id()];
+            _prev_capacity = desc.pool_capacity;
+            desc.pool_capacity = Capacity;
+        }
+
+        virtual ~pooled() {
+            component_descriptor& desc = registry()[id_of<T>::id()];
+            desc.pool_capacity = _prev_capacity;
+        }
+    };
+
+    /**
+     * indicates that released instances of <code>scope_pooled</code> bindings
+     * of the current component should be reset before they're reused. an
+     * instance whose reset throws is destroyed instead.
+     *
+     * @tparam Reset method to call on a released instance
+     */
+    template<void (T::*Reset)()>
+    class recycled_by {
+    private:
+        typename component_descriptor::activate_function _prev_reset;
+    private:
+        static void reset(void* instance) {
+            T* released = static_cast<T*>(instance);
+            (released->*Reset)();
+        }
+    public:
+        recycled_by() {
+            component_descriptor& desc = registry()[id_of<T>::id()];
+            _prev_reset = desc.reset;
+            desc.reset = &reset;
+        }
+
+        virtual ~recycled_by() {
+            component_descriptor& desc = registry()[id_of<T>::id()];
+            desc.reset = _prev_reset;
+        }
+    };
+
+#ifdef INJECT_HAS_COROUTINES
+    /**
+     * indicates that activated instances of the current component complete
+     * their initialization in a coroutine, run once they're constructed and
+     * injected. {@link context::co_instance} awaits it - other resolutions
+     * block until it completes.
+     *
+     * @tparam Init coroutine method to call on an activated instance
+     */
+    template<task<> (T::*Init)()>
+    class initialized_by {
+    private:
+        typename component_descriptor::initialize_function _prev_initializer;
+    private:
+        static task<> initialize(void* instance) {
+            T* activated = static_cast<T*>(instance);
+            return (activated->*Init)();
+        }
+    public:
+        initialized_by() {
+            component_descriptor& desc = registry()[id_of<T>::id()];
+            _prev_initializer = desc.initializer;
+            desc.initializer = &initialize;
+        }
+
+        virtual ~initialized_by() {
+            component_descriptor& desc = registry()[id_of<T>::id()];
+            desc.initializer = _prev_initializer;
+        }
+    };
+#endif
+
     /**
      * indicates the current component should be initialized with a constructor
      * different than the default constructor. up to 10 constructor arguments
@@ -197,13 +281,11 @@ public:
         class A10=void>
     class constructor {
     private:
-        generic_activator* _prev;
+        typename component_descriptor::activate_function _prev;
+        typename component_descriptor::dependencies_list _prev_dependencies;
     private:
         /** activates the component using the correct number of arguments */
-        class activator : public generic_activator {
-        public:
-            unknown_ptr activate(unknown_ptr instance);
-        };
+        static void activate(void* instance);
     public:
         constructor();
         virtual ~constructor();
@@ -213,12 +295,10 @@ public:
 #define CONSTRUCTOR_PART_SPEC_DECL(a2, a3, a4, a5, a6, a7, a8, a9) \
     class constructor<A1, a2, a3, a4, a5, a6, a7, a8, a9, void> { \
     private: \
-        generic_activator* _prev; \
+        typename component_descriptor::activate_function _prev; \
+        typename component_descriptor::dependencies_list _prev_dependencies; \
     private: \
-        class activator : public generic_activator { \
-        public: \
-            unknown_ptr activate(unknown_ptr instance); \
-        }; \
+        static void activate(void* instance); \
     public: \
         constructor(); \
         virtual ~constructor(); \
@@ -318,18 +398,16 @@ public:
     template<class Interface, typename ptr<Interface>::type& (T::*Setter)()>
     class assign_setter {
     private:
-        class activator : public generic_activator {
-        public:
-            unknown_ptr activate(unknown_ptr instance) {
-                T* activated = reinterpret_cast<T*>(instance.get());
-                (activated->*Setter)() = injected<Interface>();
-                return instance;
-            }
-        };
+        static void activate(void* instance) {
+            T* activated = static_cast<T*>(instance);
+            (activated->*Setter)() =
+                context<ID>::get_current().template instance<Interface>();
+        }
     public:
         assign_setter() {
             component_descriptor& desc = registry()[id_of<T>::id()];
-            desc.activators.push_back(new activator());
+            desc.activators.push_back(&activate);
+            desc.activator_dependencies.push_back(id_of<Interface>::id());
         }
     };
 
@@ -355,18 +433,16 @@ public:
         void (T::*Setter)(const typename ptr<Interface>::type&)>
     class arg_setter {
     private:
-        class activator : public generic_activator {
-        public:
-            unknown_ptr activate(unknown_ptr instance) {
-                T* activated = reinterpret_cast<T*>(instance.get());
-                (activated->*Setter)(injected<Interface>());
-                return instance;
-            }
-        };
+        static void activate(void* instance) {
+            T* activated = static_cast<T*>(instance);
+            (activated->*Setter)(
+                context<ID>::get_current().template instance<Interface>());
+        }
     public:
         arg_setter() {
             component_descriptor& desc = registry()[id_of<T>::id()];
-            desc.activators.push_back(new activator());
+            desc.activators.push_back(&activate);
+            desc.activator_dependencies.push_back(id_of<Interface>::id());
         }
     };
 };
@@ -30,6 +30,7 @@ template<class T>
 context<ID>::component<T>::component() {
     component_descriptor& desc = registry()[id_of<T>::id()];
     desc.id = id_of<T>::id();
+    invalidate_plans();
 }
 
 template<int ID>
@@ -41,12 +42,14 @@ context<ID>::component<T>::component(const std::string& name) {
     desc.component_name = name;
 
     registry().register_name(name, desc.id);
+    invalidate_plans();
 }
 
 template<int ID>
 template<class T>
 context<ID>::component<T>::~component() {
     registry().unregister(id_of<T>::id());
+    invalidate_plans();
 }
 
 template<int ID>
@@ -59,16 +62,18 @@ context<ID>::component<T>::provides<Interface>::provides() {
     // initialize default allocator and constructor the first time a component
     // is declared as concrete - we can't do it in component() since the class
     // may be abstract and we can't instantiate and construct abstract classes
-    if (desc.allocator == 0) {
-        desc.allocator = new allocator_activator< std::allocator<void>, T>();
+    if (desc.allocator.allocate == 0) {
+        desc.allocator =
+            allocator_activator< std::allocator<void>, T>::functions();
     }
 
     if (desc.constructor == 0) {
-        desc.constructor = new default_constructor_activator<T>();
+        desc.constructor = &default_constructor_activator<T>::activate;
     }
 
     desc.component_cast[id_of<Interface>::id()] = 
         new component_cast<T, Interface>();
+    invalidate_plans();
 }
 
 template<int ID>
@@ -85,6 +90,7 @@ context<ID>::component<T>::implemented_by<Impl, Scope>::implemented_by() {
     component_descriptor& desc = registry()[id_of<T>::id()];
     desc.default_binding = binding(
         id_of<T>::id(), id_of<Impl>::id(), Scope);
+    invalidate_plans();
 }
 
 template<int ID>
@@ -94,6 +100,7 @@ context<ID>::component<T>::implemented_by<Impl, Scope>::~implemented_by() {
     // remove default binding
     component_descriptor& desc = registry()[id_of<T>::id()];
     desc.default_binding = binding();
+    invalidate_plans();
 }
 
 template<int ID>
@@ -101,8 +108,9 @@ template<class T>
 template<class Allocator>
 context<ID>::component<T>::allocator<Allocator>::allocator() {
     component_descriptor& desc = registry()[id_of<T>::id()];
-    _prev_activator = desc.allocator;
-    desc.allocator = new allocator_activator<Allocator, T>();
+    _prev_allocator = desc.allocator;
+    desc.allocator = allocator_activator<Allocator, T>::functions();
+    invalidate_plans();
 }
 
 template<int ID>
@@ -110,7 +118,8 @@ template<class T>
 template<class Allocator>
 context<ID>::component<T>::allocator<Allocator>::~allocator() {
     component_descriptor& desc = registry()[id_of<T>::id()];
-    desc.allocator = _prev_activator;
+    desc.allocator = _prev_allocator;
+    invalidate_plans();
 }
 
 #define CONSTRUCTOR_PARTIAL_SPEC_IMPL(tmpl_decl, spec_args, ctor_args) \
@@ -120,7 +129,9 @@ tmpl_decl \
 context<ID>::component<T>::constructor<A1, spec_args>::constructor() { \
     component_descriptor& desc = registry()[id_of<T>::id()]; \
     _prev = desc.constructor; \
-    desc.constructor = new activator(); \
+    _prev_dependencies = desc.constructor_dependencies; \
+    desc.constructor = &activate; \
+    desc.constructor_dependencies = dependencies_of<A1, spec_args>(); \
 } \
  \
 template<int ID> \
@@ -129,19 +140,21 @@ tmpl_decl \
 context<ID>::component<T>::constructor<A1, spec_args>::~constructor() { \
     component_descriptor& desc = registry()[id_of<T>::id()]; \
     desc.constructor = _prev; \
+    desc.constructor_dependencies = _prev_dependencies; \
 } \
  \
 template<int ID> \
 template<class T> \
 tmpl_decl \
-typename context<ID>::unknown_ptr \
-context<ID>::component<T>::constructor<A1, spec_args>::activator:: \
-activate(unknown_ptr instance) { \
-    T* activated = reinterpret_cast<T*>(instance.get()); \
-    new(activated) T( \
+void context<ID>::component<T>::constructor<A1, spec_args>:: \
+activate(void* instance) { \
+    /* resolve all arguments with a single batch (unless prepared) */ \
+    typename instances_of<A1, spec_args>::type args = \
+        context<ID>::get_current().template arguments<A1, spec_args>( \
+            id_of<T>::id()); \
+    new(instance) T( \
         ctor_args \
     ); \
-    return instance; \
 }
 
 // a little trick from http://ingomueller.net/node/1203#comment-599
@@ -155,7 +168,7 @@ CONSTRUCTOR_PARTIAL_SPEC_IMPL(
     // spec_args
     void KO void KO void KO void KO void KO void KO void KO void KO void,
     // ctor_args
-    context<>::injected<A1>()
+    INJECT_MOVE(boost::get<0>(args))
 )
 
 CONSTRUCTOR_PARTIAL_SPEC_IMPL(
@@ -167,8 +180,8 @@ CONSTRUCTOR_PARTIAL_SPEC_IMPL(
     // spec_args
     A2 KO void KO void KO void KO void KO void KO void KO void KO void,
     // ctor_args
-    context<>::injected<A1>() KO
-    context<>::injected<A2>()
+    INJECT_MOVE(boost::get<0>(args)) KO
+    INJECT_MOVE(boost::get<1>(args))
 )
 
 CONSTRUCTOR_PARTIAL_SPEC_IMPL(
@@ -181,9 +194,9 @@ CONSTRUCTOR_PARTIAL_SPEC_IMPL(
     // spec_args
     A2 KO A3 KO void KO void KO void KO void KO void KO void KO void,
     // ctor_args
-    context<>::injected<A1>() KO
-    context<>::injected<A2>() KO
-    context<>::injected<A3>()
+    INJECT_MOVE(boost::get<0>(args)) KO
+    INJECT_MOVE(boost::get<1>(args)) KO
+    INJECT_MOVE(boost::get<2>(args))
 )
 
 CONSTRUCTOR_PARTIAL_SPEC_IMPL(
@@ -197,10 +210,10 @@ CONSTRUCTOR_PARTIAL_SPEC_IMPL(
     // spec_args
     A2 KO A3 KO A4 KO void KO void KO void KO void KO void KO void,
     // ctor_args
-    context<>::injected<A1>() KO
-    context<>::injected<A2>() KO
-    context<>::injected<A3>() KO
-    context<>::injected<A4>()
+    INJECT_MOVE(boost::get<0>(args)) KO
+    INJECT_MOVE(boost::get<1>(args)) KO
+    INJECT_MOVE(boost::get<2>(args)) KO
+    INJECT_MOVE(boost::get<3>(args))
 )
 
 CONSTRUCTOR_PARTIAL_SPEC_IMPL(
@@ -215,11 +228,11 @@ CONSTRUCTOR_PARTIAL_SPEC_IMPL(
     // spec_args
     A2 KO A3 KO A4 KO A5 KO void KO void KO void KO void KO void,
     // ctor_args
-    context<>::injected<A1>() KO
-    context<>::injected<A2>() KO
-    context<>::injected<A3>() KO
-    context<>::injected<A4>() KO
-    context<>::injected<A5>()
+    INJECT_MOVE(boost::get<0>(args)) KO
+    INJECT_MOVE(boost::get<1>(args)) KO
+    INJECT_MOVE(boost::get<2>(args)) KO
+    INJECT_MOVE(boost::get<3>(args)) KO
+    INJECT_MOVE(boost::get<4>(args))
 )
 
 CONSTRUCTOR_PARTIAL_SPEC_IMPL(
@@ -235,12 +248,12 @@ CONSTRUCTOR_PARTIAL_SPEC_IMPL(
     // spec_args
     A2 KO A3 KO A4 KO A5 KO A6 KO void KO void KO void KO void,
     // ctor_args
-    context<>::injected<A1>() KO
-    context<>::injected<A2>() KO
-    context<>::injected<A3>() KO
-    context<>::injected<A4>() KO
-    context<>::injected<A5>() KO
-    context<>::injected<A6>()
+    INJECT_MOVE(boost::get<0>(args)) KO
+    INJECT_MOVE(boost::get<1>(args)) KO
+    INJECT_MOVE(boost::get<2>(args)) KO
+    INJECT_MOVE(boost::get<3>(args)) KO
+    INJECT_MOVE(boost::get<4>(args)) KO
+    INJECT_MOVE(boost::get<5>(args))
 )
 
 CONSTRUCTOR_PARTIAL_SPEC_IMPL(
@@ -257,13 +270,13 @@ CONSTRUCTOR_PARTIAL_SPEC_IMPL(
     // spec_args
     A2 KO A3 KO A4 KO A5 KO A6 KO A7 KO void KO void KO void,
     // ctor_args
-    context<>::injected<A1>() KO
-    context<>::injected<A2>() KO
-    context<>::injected<A3>() KO
-    context<>::injected<A4>() KO
-    context<>::injected<A5>() KO
-    context<>::injected<A6>() KO
-    context<>::injected<A7>()
+    INJECT_MOVE(boost::get<0>(args)) KO
+    INJECT_MOVE(boost::get<1>(args)) KO
+    INJECT_MOVE(boost::get<2>(args)) KO
+    INJECT_MOVE(boost::get<3>(args)) KO
+    INJECT_MOVE(boost::get<4>(args)) KO
+    INJECT_MOVE(boost::get<5>(args)) KO
+    INJECT_MOVE(boost::get<6>(args))
 )
 
 CONSTRUCTOR_PARTIAL_SPEC_IMPL(
@@ -281,14 +294,14 @@ CONSTRUCTOR_PARTIAL_SPEC_IMPL(
     // spec_args
     A2 KO A3 KO A4 KO A5 KO A6 KO A7 KO A8 KO void KO void,
     // ctor_args
-    context<>::injected<A1>() KO
-    context<>::injected<A2>() KO
-    context<>::injected<A3>() KO
-    context<>::injected<A4>() KO
-    context<>::injected<A5>() KO
-    context<>::injected<A6>() KO
-    context<>::injected<A7>() KO
-    context<>::injected<A8>()
+    INJECT_MOVE(boost::get<0>(args)) KO
+    INJECT_MOVE(boost::get<1>(args)) KO
+    INJECT_MOVE(boost::get<2>(args)) KO
+    INJECT_MOVE(boost::get<3>(args)) KO
+    INJECT_MOVE(boost::get<4>(args)) KO
+    INJECT_MOVE(boost::get<5>(args)) KO
+    INJECT_MOVE(boost::get<6>(args)) KO
+    INJECT_MOVE(boost::get<7>(args))
 )
 
 CONSTRUCTOR_PARTIAL_SPEC_IMPL(
@@ -307,15 +320,15 @@ CONSTRUCTOR_PARTIAL_SPEC_IMPL(
     // spec_args
     A2 KO A3 KO A4 KO A5 KO A6 KO A7 KO A8 KO A9 KO void,
     // ctor_args
-    context<>::injected<A1>() KO
-    context<>::injected<A2>() KO
-    context<>::injected<A3>() KO
-    context<>::injected<A4>() KO
-    context<>::injected<A5>() KO
-    context<>::injected<A6>() KO
-    context<>::injected<A7>() KO
-    context<>::injected<A8>() KO
-    context<>::injected<A9>()
+    INJECT_MOVE(boost::get<0>(args)) KO
+    INJECT_MOVE(boost::get<1>(args)) KO
+    INJECT_MOVE(boost::get<2>(args)) KO
+    INJECT_MOVE(boost::get<3>(args)) KO
+    INJECT_MOVE(boost::get<4>(args)) KO
+    INJECT_MOVE(boost::get<5>(args)) KO
+    INJECT_MOVE(boost::get<6>(args)) KO
+    INJECT_MOVE(boost::get<7>(args)) KO
+    INJECT_MOVE(boost::get<8>(args))
 )
 
 CONSTRUCTOR_PARTIAL_SPEC_IMPL(
@@ -335,16 +348,16 @@ CONSTRUCTOR_PARTIAL_SPEC_IMPL(
     // spec_args
     A2 KO A3 KO A4 KO A5 KO A6 KO A7 KO A8 KO A9 KO A10,
     // ctor_args
-    context<>::injected<A1>() KO
-    context<>::injected<A2>() KO
-    context<>::injected<A3>() KO
-    context<>::injected<A4>() KO
-    context<>::injected<A5>() KO
-    context<>::injected<A6>() KO
-    context<>::injected<A7>() KO
-    context<>::injected<A8>() KO
-    context<>::injected<A9>() KO
-    context<>::injected<A10>()
+    INJECT_MOVE(boost::get<0>(args)) KO
+    INJECT_MOVE(boost::get<1>(args)) KO
+    INJECT_MOVE(boost::get<2>(args)) KO
+    INJECT_MOVE(boost::get<3>(args)) KO
+    INJECT_MOVE(boost::get<4>(args)) KO
+    INJECT_MOVE(boost::get<5>(args)) KO
+    INJECT_MOVE(boost::get<6>(args)) KO
+    INJECT_MOVE(boost::get<7>(args)) KO
+    INJECT_MOVE(boost::get<8>(args)) KO
+    INJECT_MOVE(boost::get<9>(args))
 )
 
 #undef KO
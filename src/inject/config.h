@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_CONFIG_H__
+#define __INJECT_CONFIG_H__
+
+/*
+ * compile-time options - define before including inject:
+ *
+ * INJECT_THREAD_CACHE
+ *     keep a small per-thread cache of resolution plans in front of
+ *     context::instance(), so repeated resolves of the same interfaces on a
+ *     thread are served from that thread's own memory
+ */
+
+/**
+ * storage class specifier of thread-local variables. only use it with POD
+ * types - before C++11 this falls back to compiler extensions, which don't
+ * support constructors or destructors
+ */
+#if __cplusplus >= 201103L
+    #define INJECT_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+    #define INJECT_THREAD_LOCAL __declspec(thread)
+#else
+    #define INJECT_THREAD_LOCAL __thread
+#endif
+
+/**
+ * defined if rvalue references are available - pointers are then moved along
+ * the resolution path, instead of copied
+ */
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1600)
+    #define INJECT_HAS_RVALUE_REFERENCES
+#endif
+
+/** moves from an lvalue if possible, otherwise copies it */
+#ifdef INJECT_HAS_RVALUE_REFERENCES
+    #include <utility>
+    #define INJECT_MOVE(x) std::move(x)
+#else
+    #define INJECT_MOVE(x) (x)
+#endif
+
+/**
+ * defined if the standard library provides allocator_traits - allocators are
+ * then rebound through it
+ */
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1700)
+    #define INJECT_HAS_ALLOCATOR_TRAITS
+#endif
+
+/**
+ * defined if the standard library provides atomics and mutexes - otherwise
+ * boost's are used
+ */
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1700)
+    #define INJECT_HAS_STD_THREADS
+#endif
+
+/**
+ * defined if the compiler supports coroutines (C++20) - components may then
+ * complete their initialization in one
+ */
+#if defined(__cpp_impl_coroutine) && defined(INJECT_HAS_STD_THREADS)
+    #define INJECT_HAS_COROUTINES
+#endif
+
+#endif // __INJECT_CONFIG_H__
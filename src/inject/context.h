@@ -25,18 +25,37 @@
 
 #include <assert.h>
 
+#include <algorithm>
+#include <climits>
 #include <string>
 #include <memory>
 #include <map>
 #include <list>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/tuple/tuple.hpp>
 
+#include "config.h"
+#include "pointer_policy.h"
 #include "id_of.h"
 #include "exceptions.h"
 #include "context_config.h"
 #include "types.h"
 #include "binding.h"
+#include "binding_table.h"
+#include "id_map.h"
+#include "epoch.h"
+#include "segmented_table.h"
+#include "sync.h"
+#include "task.h"
+
+#ifdef INJECT_HAS_STD_THREADS
+#include <condition_variable>
+#include <future>
+#endif
 
 #include "debug.h"
 
@@ -50,7 +69,11 @@ namespace inject {
  * @tparam ID used to support multiple injection contexts in the same
  *         application
  *
- * @todo explain about the current context stack
+ * each thread has its own stack of contexts - a context is pushed to the stack
+ * of the thread constructing it, and popped when it's destroyed, so it must be
+ * destroyed by that thread, in reverse order. the top of the stack is the
+ * thread's current context, which {@link injected} uses, and the global
+ * context is at the bottom of every stack.
  */
 template<int ID = 0>
 class context {
@@ -60,10 +83,27 @@ private: // classes
     template< class From, class To >
     class component_cast;
 
-    class generic_activator;
+    struct allocator_functions;
     struct component_descriptor;
+    struct resolution_plan;
+    struct plan_entry;
+    struct singleton_slot;
+    struct waiting_thread;
+    struct pool_slot;
+    struct thread_cache_entry;
+    struct prepared_arguments;
+#ifdef INJECT_HAS_COROUTINES
+    struct deferred_initialization;
+    struct co_resolution;
+#endif
 
     class components_registry;
+    class current_guard;
+    class instance_pool;
+    class instance_arena;
+
+    template<class T, class Unused = void>
+    struct instance_slot;
 
     //template<class Allocator, class Activated>
     //class activator;
@@ -80,29 +120,170 @@ public: // classes
     
     template<class T>
     class injected;
+
+    template<class T>
+    class singleton_ref;
+private: // pointer policy
+    typedef typename context_traits<ID>::pointer_policy pointer_policy;
+    typedef typename pointer_policy::custom_ownership custom_ownership;
 public: // component pointer type
     /**
-     * abstracts the actual pointer used, in case we want to change it sometime
-     * in the future
-     * @todo C++11 std::shared_ptr if available ?
+     * abstracts the actual pointer used - selected by the context's
+     * {@link context_traits}
      */
     template<class T>
     struct ptr {
         /** the pointer type */
-        typedef boost::shared_ptr<T> type;
+        typedef typename pointer_policy::template pointer<T>::type type;
+    };
+
+    /**
+     * the result of a batched resolution: a boost::tuple of pointers to the
+     * given interfaces (<code>void</code> arguments are left out)
+     */
+    template<
+        class A1,
+        class A2=void,
+        class A3=void,
+        class A4=void,
+        class A5=void,
+        class A6=void,
+        class A7=void,
+        class A8=void,
+        class A9=void,
+        class A10=void>
+    struct instances_of {
+        /** the tuple type */
+        typedef boost::tuple<
+            typename instance_slot<A1>::type,
+            typename instance_slot<A2>::type,
+            typename instance_slot<A3>::type,
+            typename instance_slot<A4>::type,
+            typename instance_slot<A5>::type,
+            typename instance_slot<A6>::type,
+            typename instance_slot<A7>::type,
+            typename instance_slot<A8>::type,
+            typename instance_slot<A9>::type,
+            typename instance_slot<A10>::type> type;
     };
 private: // types
     typedef typename ptr<unknown_component>::type unknown_ptr;
-    typedef std::map<unique_id, binding> bindings_map;
-    typedef std::map<unique_id, unknown_ptr> instances_map;
+    typedef binding_table bindings_map;
+    typedef segmented_table<singleton_slot> singletons_map;
+    typedef segmented_table<plan_entry> plans_map;
+    typedef segmented_table<pool_slot> pools_map;
 private: // members
+    /**
+     * storage of the instances this context creates, if it's arena-backed.
+     * declared first, so it's destroyed last
+     */
+    boost::scoped_ptr<instance_arena> _arena;
+
+    /** bindings made in this context */
     bindings_map _bindings;
-    instances_map _singletons;
+
+    /** bindings in effect - this context's, and the ones inherited */
+    bindings_map _effective;
+
+    /**
+     * bumped whenever <code>_bindings</code>, or those of a parent, change -
+     * invalidates the plans of this context
+     */
+    atomic<unsigned long> _generation;
+
+    /** generation <code>_effective</code> was flattened in */
+    unsigned long _effective_generation;
+
+    /** singletons of this context, by component id */
+    singletons_map _singletons;
+
+    /** idle instances of pooled components, by component id */
+    pools_map _pools;
+
+    plans_map _plans;
+
+    /** replaced plans, waiting for their readers to be done */
+    resolution_plan* _retired;
+
+    /**
+     * held while binding, and while compiling plans (and flattening bindings
+     * for them)
+     */
+    mutex _lock;
+
+    /**
+     * identifies this context's plans table in the thread caches. unlike the
+     * context's address it is never reused
+     */
+    unsigned long _serial;
+
     context<ID>* _parent;
+
+    /** contexts on top of this one, whose bindings it changes */
+    std::vector<context<ID>*> _children;
+
+    /** held while <code>_children</code> change, or are invalidated */
+    mutex _children_lock;
 private:
     unknown_ptr instance(unique_id interface_id);
+    unknown_ptr resolve(unique_id interface_id);
+    unknown_ptr share(component_descriptor& desc, generic_component_cast* cast,
+        unique_id interface_id);
     binding find_binding(unique_id interface_id);
+    const bindings_map& effective_bindings();
+    resolution_plan& plan(unique_id interface_id);
+    resolution_plan* compile(unique_id interface_id);
+    void reclaim(unsigned long oldest);
     void init();
+#ifdef INJECT_HAS_COROUTINES
+    task<unknown_ptr> co_resolve(unique_id interface_id,
+        const co_resolution* dependent = 0);
+#endif
+#ifdef INJECT_HAS_STD_THREADS
+    unknown_ptr instance_prepared(unique_id interface_id);
+    void singleton_dependencies(unique_id component_id,
+        std::vector<unique_id>& found, std::vector<unique_id>& visited);
+#endif
+
+    /**
+     * @return interfaces among the arguments (<code>void</code> arguments are
+     *         left out)
+     */
+    template<class A1, class A2, class A3, class A4, class A5,
+        class A6, class A7, class A8, class A9, class A10>
+    static typename component_descriptor::dependencies_list dependencies_of() {
+        typename component_descriptor::dependencies_list ids;
+        instance_slot<A1>::depend(ids);
+        instance_slot<A2>::depend(ids);
+        instance_slot<A3>::depend(ids);
+        instance_slot<A4>::depend(ids);
+        instance_slot<A5>::depend(ids);
+        instance_slot<A6>::depend(ids);
+        instance_slot<A7>::depend(ids);
+        instance_slot<A8>::depend(ids);
+        instance_slot<A9>::depend(ids);
+        instance_slot<A10>::depend(ids);
+        return ids;
+    }
+
+    /**
+     * resolves a component's constructor arguments - taking the ones prepared
+     * for it on this thread, if any
+     * @param component_id component being constructed
+     */
+    template<class A1, class A2, class A3, class A4, class A5,
+        class A6, class A7, class A8, class A9, class A10>
+    typename instances_of<A1, A2, A3, A4, A5, A6, A7, A8, A9, A10>::type
+    arguments(unique_id component_id);
+
+private: // the global context
+    struct global_tag { };
+
+    /**
+     * constructs the global context - it's at the bottom of every thread's
+     * stack, so it isn't pushed to any
+     */
+    explicit context(global_tag);
 private: // disallow copy-ctor and assign operator
     context(const context<ID>& other) : _parent(other._parent) { }
     context<ID>& operator=(const context<ID>& other) {
@@ -111,9 +292,20 @@ private: // disallow copy-ctor and assign operator
     }
 public: // constructors
     /** constructs an empty context, with no components */
-    context() { init(); }
+    context() : _generation(0) { init(); }
     /** @param config a source of initial component bindings */
     context(context_config& config);
+
+    /**
+     * constructs an empty, arena-backed context. every instance this context
+     * creates (except for <code>scope_pooled</code> bindings) is allocated
+     * from an arena it owns, instead of through the component's allocator.
+     * the instances are destroyed in reverse creation order, and their memory
+     * released at once, when the context is destroyed - pointers to them must
+     * not outlive the context.
+     */
+    explicit context(arena_type);
+
     virtual ~context();
 public: // methods
 
@@ -160,10 +352,12 @@ public: // methods
      */
     template<class Interface, class Impl, component_scope Scope>
     void bind() {
-        _bindings[id_of<Interface>::id()] = binding(
+        scoped_lock lock(_lock);
+        _bindings.set(binding(
             id_of<Interface>::id(),
             id_of<Impl>::id(),
-            Scope);
+            Scope));
+        invalidate_bindings();
     }
 
     /**
@@ -193,7 +387,10 @@ public: // methods
             component_scope scope) {
         unique_id what_id = registry()[what].id;
         unique_id to_id = registry()[to].id;
-        _bindings[what_id] = binding(what_id, to_id, scope);
+
+        scoped_lock lock(_lock);
+        _bindings.set(binding(what_id, to_id, scope));
+        invalidate_bindings();
     }
 
     /**
@@ -209,16 +406,242 @@ public: // methods
     template<class Interface>
     typename ptr<Interface>::type instance();
 
+    /**
+     * borrows the singleton registered as the implementation of the given
+     * interface. no reference is taken - the context keeps its singletons
+     * alive for as long as it lives. it still reads the current plan, which
+     * takes an epoch announcement and a few atomic loads - keep the reference
+     * rather than borrowing it again on hot paths
+     * @return reference to the singleton
+     * @tparam Interface type to borrow
+     * @throws no_component
+     * @throws no_binding
+     * @throws not_providing
+     * @throws not_singleton
+     * @throws circular_dependency
+     */
+    template<class Interface>
+    Interface& singleton();
+
+    /**
+     * obtains pointers to <code>n</code> instances implementing the given
+     * interface. for a <code>scope_none</code> binding, the binding is
+     * resolved once and all instances are allocated with a single call to the
+     * component's allocator, then activated one after the other. the memory
+     * is given back once all of them are released.
+     * @param n number of instances
+     * @param out where to write the pointers to
+     * @return <code>out</code>, past the last pointer written
+     * @tparam Interface type to obtain pointers to
+     * @tparam OutputIterator output iterator of <code>ptr<Interface>::type</code>
+     * @throws no_component
+     * @throws no_binding
+     * @throws not_providing
+     * @throws circular_dependency
+     */
+    template<class Interface, class OutputIterator>
+    OutputIterator instantiate_n(std::size_t n, OutputIterator out);
+
+#ifdef INJECT_HAS_STD_THREADS
+    /**
+     * obtains a pointer to an instance implementing the given interface in the
+     * background, on the {@link executor} shared by all contexts. for a
+     * <code>scope_none</code> binding, the arguments of the component's
+     * declared constructor are resolved in parallel (each interface as a job
+     * of its own - one after the other in an arena context), and the component
+     * is constructed once all of them are. the context must outlive the
+     * returned future's result.
+     * @return future of the pointer to implementing instance, or of the
+     *         exception {@link instance} would throw
+     * @tparam Interface type to obtain pointer to
+     */
+    template<class Interface>
+    std::future<typename ptr<Interface>::type> instance_async();
+
+    /**
+     * activates all singletons bound in this context (or inherited) ahead of
+     * their first use, in parallel. a singleton is only activated once the
+     * singletons it depends on - through its declared constructor and
+     * setters, possibly via non-singleton components - are, so independent
+     * singletons are activated at the same time, as jobs of the shared
+     * {@link executor}. the calling thread waits for them.
+     * @param threads most activations running at once
+     * @throws the exception of the first activation that failed
+     */
+    void warm_up(unsigned threads);
+#endif
+
+#ifdef INJECT_HAS_COROUTINES
+    /**
+     * obtains a pointer to an instance implementing the given interface,
+     * awaiting the initialization coroutines of the components activated
+     * instead of blocking on them. for a <code>scope_none</code> binding, the
+     * arguments of the component's declared constructor are started together
+     * and awaited before it's constructed, so their initialization overlaps.
+     * other bindings are resolved (and initialized) as by {@link instance}.
+     * components with an initialization coroutine that are activated along
+     * the way by other means (e.g. injected fields) aren't waited for -
+     * blocking the thread running this coroutine could keep them from ever
+     * completing - so they fail with {@link blocking_initialization}.
+     * @return task completing with the pointer to implementing instance
+     * @tparam Interface type to obtain pointer to
+     */
+    template<class Interface>
+    task<typename ptr<Interface>::type> co_instance();
+#endif
+
+    /**
+     * obtains pointers to the instances implementing a set of interfaces in a
+     * single pass - the context is made current once for the whole set,
+     * instead of once per interface. <code>void</code> arguments are ignored.
+     * @return boost::tuple of pointers to implementing instances
+     * @tparam A1..A10 types to obtain pointers to
+     * @throws no_component
+     * @throws no_binding
+     * @throws not_providing
+     * @throws circular_dependency
+     */
+    template<class A1, class A2, class A3, class A4, class A5,
+        class A6, class A7, class A8, class A9, class A10>
+    typename instances_of<A1, A2, A3, A4, A5, A6, A7, A8, A9, A10>::type
+    instances();
+
+    /** @see instances */
+    template<class A1>
+    typename instances_of<A1>::type instances() {
+        return instances<A1, void, void, void, void,
+            void, void, void, void, void>();
+    }
+
+    /** @see instances */
+    template<class A1, class A2>
+    typename instances_of<A1, A2>::type instances() {
+        return instances<A1, A2, void, void, void,
+            void, void, void, void, void>();
+    }
+
+    /** @see instances */
+    template<class A1, class A2, class A3>
+    typename instances_of<A1, A2, A3>::type instances() {
+        return instances<A1, A2, A3, void, void,
+            void, void, void, void, void>();
+    }
+
+    /** @see instances */
+    template<class A1, class A2, class A3, class A4>
+    typename instances_of<A1, A2, A3, A4>::type instances() {
+        return instances<A1, A2, A3, A4, void,
+            void, void, void, void, void>();
+    }
+
+    /** @see instances */
+    template<class A1, class A2, class A3, class A4, class A5>
+    typename instances_of<A1, A2, A3, A4, A5>::type instances() {
+        return instances<A1, A2, A3, A4, A5,
+            void, void, void, void, void>();
+    }
+
+    /** @see instances */
+    template<class A1, class A2, class A3, class A4, class A5,
+        class A6>
+    typename instances_of<A1, A2, A3, A4, A5, A6>::type instances() {
+        return instances<A1, A2, A3, A4, A5,
+            A6, void, void, void, void>();
+    }
+
+    /** @see instances */
+    template<class A1, class A2, class A3, class A4, class A5,
+        class A6, class A7>
+    typename instances_of<A1, A2, A3, A4, A5, A6, A7>::type instances() {
+        return instances<A1, A2, A3, A4, A5,
+            A6, A7, void, void, void>();
+    }
+
+    /** @see instances */
+    template<class A1, class A2, class A3, class A4, class A5,
+        class A6, class A7, class A8>
+    typename instances_of<A1, A2, A3, A4, A5, A6, A7, A8>::type instances() {
+        return instances<A1, A2, A3, A4, A5,
+            A6, A7, A8, void, void>();
+    }
+
+    /** @see instances */
+    template<class A1, class A2, class A3, class A4, class A5,
+        class A6, class A7, class A8, class A9>
+    typename instances_of<A1, A2, A3, A4, A5, A6, A7, A8, A9>::type
+    instances() {
+        return instances<A1, A2, A3, A4, A5,
+            A6, A7, A8, A9, void>();
+    }
+
 private:
-    unknown_ptr instantiate(component_descriptor& desc);
+    unknown_ptr instantiate(component_descriptor& desc, instance_arena* arena);
+    unknown_ptr lend(component_descriptor& desc, generic_component_cast* cast,
+        unique_id interface_id, boost::true_type);
+    unknown_ptr lend(component_descriptor& desc, generic_component_cast* cast,
+        unique_id interface_id, boost::false_type);
+    static unknown_ptr activate(component_descriptor& desc,
+        instance_arena& arena, boost::true_type);
+    static unknown_ptr activate(component_descriptor& desc,
+        instance_arena& arena, boost::false_type);
 
 public: // static methods
-    /** @return reference to current context */
+    /**
+     * @return reference to the calling thread's current context, or to the
+     *         global context if the thread has none
+     */
     static context<ID>& get_current();
-private: // context list, components registry
+private: // per-thread context stack, components registry
+    static context<ID>& global();
     static context<ID>*& head();
     static context<ID>*& current();
     static components_registry& registry();
+private: // resolution plans invalidation
+    /** bumped whenever components change - invalidates every plan */
+    static atomic<unsigned long>& plans_generation();
+    static void invalidate_plans();
+
+    /**
+     * @return generation of this context's plans - changes once components,
+     *         or the bindings of this context or of a parent, change
+     */
+    unsigned long generation() const;
+
+    /** bumps the generation of this context, and of the ones on top of it */
+    void invalidate_bindings();
+    static unsigned long next_serial();
+private: // singletons activated (or waited for) on this thread
+    static waiting_thread* waiting();
+
+    /**
+     * held while a thread takes or releases a singleton slot, or starts or
+     * stops waiting for one - so threads waiting for each other see a
+     * consistent chain
+     */
+    static mutex& waiting_lock();
+
+    /**
+     * takes a singleton slot, or starts waiting for it. call with the slot's
+     * lock held
+     * @param slot slot to take
+     * @param component_id component activated in the slot
+     * @return whether the calling thread took it
+     * @throws circular_dependency if the slot's owner waits, directly or
+     *         through other threads, for the calling thread
+     */
+    static bool take(singleton_slot& slot, unique_id component_id);
+
+    /** gives a singleton slot back, and wakes the threads waiting for it */
+    static void release(singleton_slot& slot);
+private: // arguments prepared for the constructor activated on this thread
+    static prepared_arguments*& prepared();
+#ifdef INJECT_HAS_COROUTINES
+    static deferred_initialization*& deferred();
+#endif
+private: // per-thread resolution cache
+    /** number of entries in each thread's cache, must be a power of two */
+    static const std::size_t thread_cache_size = 64;
+    static thread_cache_entry* thread_cache();
 };
 
 /**
@@ -276,16 +699,16 @@ public:
 public:
 
     /**
-     * Casts the given component pointer to the appropriate type component
-     * pointer.
+     * Casts the given component pointer, in place, to the appropriate type
+     * component pointer. The pointer keeps its ownership, so nothing has to
+     * be reference-counted if it can be moved.
      *
      * @param ptr Pointer to cast. Must be of the correct type, otherwise a
      *        <code>bad_cast</code> exception will be thrown.
-     * @return cast pointer
      * @throws bad_cast If the given pointer is not a valid pointer, or doesn't
      *         point to the expected type
      */
-    virtual unknown_ptr cast(unknown_ptr ptr) = 0;
+    virtual void cast(unknown_ptr& ptr) = 0;
 };
 
 /**
@@ -312,38 +735,81 @@ public:
 
 public:
 
-    unknown_ptr cast(unknown_ptr instance);
+    void cast(unknown_ptr& instance);
 };
 
 /**
- * A (non-template) base class for all activators. an activator is part of a
- * chain, that prepares an instance.
- *
- * activating a type means executing, in order, the chain of its activators
- * (which may allocate, construct or inject dependencies)
+ * The functions a component's allocator declaration provides. All of them
+ * operate on a single instance of the component.
  */
 template<int ID>
-class context<ID>::generic_activator {
-private:
-    generic_activator* _next;
-public:
-    generic_activator() : _next(0) { }
-    virtual ~generic_activator() { }
+struct context<ID>::allocator_functions {
+
+    /* --- Types --- */
+
 public:
+
     /**
-     * activate the given instance, performing some part of the initialization
-     * process.
-     *
-     * @param instance instance to activate
-     * @return instance to pass to next activator
+     * allocates uninitialized memory for an instance, along with the
+     * reference count of the returned pointer. the memory is deallocated when
+     * the last pointer to it is released
      */
-    virtual unknown_ptr activate(unknown_ptr instance) = 0;
+    typedef unknown_ptr (*allocate_function)();
 
-    /** @return next activator in activation chain */
-    const generic_activator* next() const { return _next; }
-    
-    /** @return next activator in activation chain */
-    generic_activator*& next() { return _next; }
+    /**
+     * marks an instance, constructed in memory returned by
+     * <code>allocate</code>, as owned - it's destroyed before its memory is
+     * deallocated
+     */
+    typedef void (*adopt_function)(void* instance);
+
+    /**
+     * allocates uninitialized memory for consecutive instances. the returned
+     * pointer owns the memory, and deallocates it (without destroying
+     * anything) when the last pointer to it is released
+     */
+    typedef unknown_ptr (*allocate_block_function)(std::size_t n);
+
+    /**
+     * takes ownership of a constructed instance inside a block, which is
+     * destroyed when the last pointer to it is released. the instance keeps
+     * the block alive
+     */
+    typedef unknown_ptr (*adopt_in_block_function)(void* instance,
+        const unknown_ptr& block);
+
+    /** destroys a constructed instance, without deallocating it */
+    typedef void (*destroy_function)(void* instance);
+
+    /* --- Constructor --- */
+
+public:
+
+    /** initialize without an allocator */
+    allocator_functions() :
+        allocate(0),
+        adopt(0),
+        allocate_block(0),
+        adopt_in_block(0),
+        destroy(0),
+        instance_size(0),
+        instance_alignment(0) { }
+
+    /* --- Fields --- */
+
+public:
+
+    allocate_function allocate;
+    adopt_function adopt;
+    allocate_block_function allocate_block;
+    adopt_in_block_function adopt_in_block;
+    destroy_function destroy;
+
+    /** distance between consecutive instances in a block */
+    std::size_t instance_size;
+
+    /** alignment required by an instance */
+    std::size_t instance_alignment;
 };
 
 /**
@@ -357,10 +823,22 @@ struct context<ID>::component_descriptor {
 public:
 
     /** map target component to appropriate case provider */
-    typedef std::map<unique_id, generic_component_cast*> component_cast_map;
+    typedef id_map<generic_component_cast*> component_cast_map;
+
+    /**
+     * performs some part of the initialization of an allocated instance
+     * (constructs it, or injects its dependencies)
+     */
+    typedef void (*activate_function)(void* instance);
     
     /** list of activators */
-    typedef std::list<generic_activator*> activators_list;
+    typedef std::vector<activate_function> activators_list;
+
+    /** interfaces an activation resolves */
+    typedef std::vector<unique_id> dependencies_list;
+
+    /** number of idle instances kept by a pool unless declared otherwise */
+    static const std::size_t default_pool_capacity = 16;
 
     /* --- Constructor --- */
 
@@ -369,10 +847,53 @@ public:
     /** initialize component with an invalid id */
     component_descriptor() :
         id(INVALID_ID),
-        allocator(0),
+        allocator(),
         constructor(0),
+        pool_capacity(default_pool_capacity),
+        reset(0),
+#ifdef INJECT_HAS_COROUTINES
+        initializer(0),
+#endif
         activating(false) { }
 
+    /* --- Methods --- */
+
+public:
+
+    /**
+     * creates a new instance - allocates it, constructs it and runs its
+     * activators, passing the raw instance between the stages
+     *
+     * @return pointer owning the new instance
+     */
+    unknown_ptr activate() const;
+
+    /**
+     * creates a new instance in an arena, ignoring the allocator
+     *
+     * @param arena arena to allocate from, which destroys the instance
+     * @return pointer to the new instance, which doesn't own it
+     */
+    unknown_ptr activate(instance_arena& arena) const;
+
+    /**
+     * initializes an instance allocated in a block - constructs it and runs
+     * its activators
+     *
+     * @param instance uninitialized instance, inside <code>block</code>
+     * @param block block returned by <code>allocator.allocate_block</code>
+     * @return pointer owning the new instance
+     */
+    unknown_ptr activate_in(void* instance, const unknown_ptr& block) const;
+
+    /**
+     * runs the initialization coroutine of an activated instance, if any, and
+     * blocks until it completes - unless its completion is awaited instead
+     *
+     * @param instance constructed and injected instance
+     */
+    void initialize(void* instance) const;
+
     /* --- Fields --- */
 
 public:
@@ -380,20 +901,43 @@ public:
     /** component id */
     unique_id id;
 
-    /** mandatory activator which allocates an uninitialized instance */
-    generic_activator* allocator;
+    /** mandatory functions which allocate and own instances */
+    allocator_functions allocator;
 
     /**
      * mandatory activator which initializes an allocated instance using one of
      * its constructors
      */
-    generic_activator* constructor;
+    activate_function constructor;
 
     /**
-     * optional activators list
+     * optional activators list, run in order after construction
      */
     activators_list activators;
 
+    /** interfaces the declared constructor is passed */
+    dependencies_list constructor_dependencies;
+
+    /** interfaces the declared setters are passed */
+    dependencies_list activator_dependencies;
+
+    /** maximal number of idle instances kept for a pooled binding */
+    std::size_t pool_capacity;
+
+    /**
+     * optional hook, resetting a released instance of a pooled binding before
+     * it's reused
+     */
+    activate_function reset;
+
+#ifdef INJECT_HAS_COROUTINES
+    /** completes the initialization of an activated instance */
+    typedef task<> (*initialize_function)(void* instance);
+
+    /** optional coroutine, run after the activators */
+    initialize_function initializer;
+#endif
+
     /** component's name */
     std::string component_name;
 
@@ -410,6 +954,306 @@ public:
     bool activating;
 };
 
+/**
+ * A compiled resolution of an interface in a specific context. Resolving an
+ * interface requires finding its binding (possibly through the parent
+ * contexts), its implementation's descriptor and the matching cast provider.
+ * The context does that once per interface, and keeps the result until a
+ * binding or a component declaration changes.
+ *
+ * A published plan is never changed (except for publishing its singleton) -
+ * a binding change publishes a new plan instead, and the replaced one is
+ * reclaimed once no thread can be reading it.
+ */
+template<int ID>
+struct context<ID>::resolution_plan {
+
+    /* --- Constructor --- */
+
+public:
+
+    /** @param generation generation the plan is compiled in */
+    explicit resolution_plan(unsigned long generation) :
+        generation(generation),
+        descriptor(0),
+        cast(0),
+        scope(scope_none),
+        published(0),
+        retired(0),
+        next_retired(0) { }
+
+    /* --- Fields --- */
+
+public:
+
+    /** generation of its context this plan was compiled in */
+    unsigned long generation;
+
+    /** descriptor of the implementing component */
+    component_descriptor* descriptor;
+
+    /** casts the implementing component to the resolved interface */
+    generic_component_cast* cast;
+
+    /** binding scope */
+    component_scope scope;
+
+    /**
+     * the singleton instance, already cast to the resolved interface. only
+     * used in <code>scope_singleton</code>, and empty until first activated
+     */
+    unknown_ptr singleton;
+
+    /**
+     * the singleton's address, stored once <code>singleton</code> is set - the
+     * only thing a resolving thread reads before it may use it
+     */
+    atomic<unknown_component*> published;
+
+    /** {@link epoch} stamp of the plan, once it's replaced */
+    unsigned long retired;
+
+    /** next replaced plan waiting to be reclaimed */
+    resolution_plan* next_retired;
+};
+
+/**
+ * The published plan of an interface in a context's plans table.
+ */
+template<int ID>
+struct context<ID>::plan_entry {
+
+    /* --- Constructor --- */
+
+public:
+
+    plan_entry() : plan(0) { }
+
+    ~plan_entry() { delete plan.load(memory_order_relaxed); }
+
+    /* --- Fields --- */
+
+public:
+
+    /** the current plan, or <code>0</code> if it wasn't compiled yet */
+    atomic<resolution_plan*> plan;
+};
+
+/**
+ * A singleton of a context. Only the first thread to activate the component
+ * owns the slot - others wait for it, and later resolutions go through the
+ * plans, which keep the singleton themselves.
+ */
+template<int ID>
+struct context<ID>::singleton_slot {
+
+    /* --- Constructor --- */
+
+public:
+
+    singleton_slot() : owner(0) { }
+
+    /* --- Fields --- */
+
+public:
+
+    /** held while the slot is taken, released or waited for */
+    mutex lock;
+
+#ifdef INJECT_HAS_STD_THREADS
+    /** notified when the slot is released */
+    std::condition_variable released;
+#endif
+
+    /** the singleton instance - only accessed by the owner */
+    unknown_ptr instance;
+
+    /**
+     * the thread activating the singleton and publishing it to plans, if
+     * any. changed with both the slot's lock and the waiting lock held
+     */
+    waiting_thread* owner;
+};
+
+/**
+ * what a thread activating singletons waits for, so threads waiting for each
+ * other are found out instead of waiting forever. a thread waits for nothing
+ * once it's done activating, so its record outlives every reference to it
+ */
+template<int ID>
+struct context<ID>::waiting_thread {
+    /**
+     * slot of the singleton the thread waits for, if any. changed with the
+     * waiting lock held
+     */
+    singleton_slot* waiting_for;
+};
+
+/**
+ * the pool of a pooled component in a context, created the first time it's
+ * needed
+ */
+template<int ID>
+struct context<ID>::pool_slot {
+    /** held while getting (or creating) the pool */
+    mutex lock;
+
+    /** the pool - only accessed under <code>lock</code> */
+    boost::shared_ptr<instance_pool> pool;
+};
+
+/**
+ * An entry of the per-thread resolution cache, pointing to a plan of some
+ * context. The entry is plain-old-data, so it can be kept in thread-local
+ * storage even before C++11. A plan is only replaced once the generation
+ * changes, so an entry of the current generation points to a published plan.
+ */
+template<int ID>
+struct context<ID>::thread_cache_entry {
+    /** serial of the context owning the plan */
+    unsigned long serial;
+
+    /** resolved interface */
+    unique_id interface_id;
+
+    /** generation of the context the entry was cached in */
+    unsigned long generation;
+
+    /** cached plan */
+    resolution_plan* plan;
+};
+
+/**
+ * Constructor arguments resolved ahead of constructing a component, taken by
+ * the component's constructor instead of resolving them itself.
+ */
+template<int ID>
+struct context<ID>::prepared_arguments {
+    /** component being constructed */
+    unique_id component_id;
+
+    /** interface of each argument */
+    typename component_descriptor::dependencies_list interfaces;
+
+    /** instance of each argument, already cast to its interface */
+    std::vector<unknown_ptr> instances;
+};
+
+#ifdef INJECT_HAS_COROUTINES
+/**
+ * Receives the initialization of the component activated on this thread, to
+ * be awaited instead of blocked on.
+ */
+template<int ID>
+struct context<ID>::deferred_initialization {
+    /** component being activated */
+    unique_id component_id;
+
+    /** its running initialization coroutine, if it has one */
+    task<> initialization;
+};
+
+/**
+ * A component being resolved by a coroutine, waiting for its arguments. The
+ * chain of them is how the arguments find out they depend on themselves.
+ */
+template<int ID>
+struct context<ID>::co_resolution {
+    /** component being resolved */
+    unique_id component_id;
+
+    /** the resolution this one is an argument of, if any */
+    const co_resolution* dependent;
+};
+#endif
+
+/**
+ * Makes a context the current one for its lifetime, restoring the previous
+ * current context when destroyed (also when activation throws).
+ */
+template<int ID>
+class context<ID>::current_guard {
+private:
+    /** the context that was current before */
+    context<ID>* _backup;
+
+    // non-copyable
+    current_guard(const current_guard&);
+    current_guard& operator=(const current_guard&);
+public:
+    /** @param ctx context to make current */
+    explicit current_guard(context<ID>* ctx) : _backup(current()) {
+        current() = ctx;
+    }
+
+    ~current_guard() {
+        current() = _backup;
+    }
+};
+
+/**
+ * A slot of a batched resolution's result: a pointer to the interface,
+ * resolved while the context is already current
+ */
+template<int ID>
+template<class T, class Unused>
+struct context<ID>::instance_slot {
+    /** slot type */
+    typedef typename ptr<T>::type type;
+
+    /** @return pointer to the instance implementing <code>T</code> */
+    static type resolve(context<ID>& ctx) {
+        return pointer_policy::template typed<T>(
+            ctx.resolve(id_of<T>::id()));
+    }
+
+    /**
+     * @param args arguments prepared for the constructor, or <code>0</code>
+     * @param index argument position
+     * @return pointer to the prepared instance, if it's of <code>T</code>, or
+     *         to the instance implementing <code>T</code>
+     */
+    static type take(context<ID>& ctx, prepared_arguments* args,
+            std::size_t index) {
+        if (args != 0 && index < args->instances.size() &&
+                args->interfaces[index] == id_of<T>::id()) {
+            return pointer_policy::template typed<T>(
+                INJECT_MOVE(args->instances[index]));
+        }
+
+        return resolve(ctx);
+    }
+
+    /** @param ids list to add <code>T</code> to */
+    static void depend(
+            typename component_descriptor::dependencies_list& ids) {
+        ids.push_back(id_of<T>::id());
+    }
+};
+
+/**
+ * An unused slot of a batched resolution's result
+ */
+template<int ID>
+template<class Unused>
+struct context<ID>::instance_slot<void, Unused> {
+    /** slot type */
+    typedef boost::tuples::null_type type;
+
+    /** @return nothing */
+    static type resolve(context<ID>&) {
+        return type();
+    }
+
+    /** @return nothing */
+    static type take(context<ID>&, prepared_arguments*, std::size_t) {
+        return type();
+    }
+
+    /** adds nothing */
+    static void depend(typename component_descriptor::dependencies_list&) { }
+};
+
 /**
  * The centralized components registry
  */
@@ -420,8 +1264,11 @@ class context<ID>::components_registry {
 
 private:
 
-    /** map unique ids and component descriptors */
-    typedef std::map<unique_id, component_descriptor> id_to_descriptor_map;
+    /**
+     * component descriptors, indexed by unique id. descriptors never move, so
+     * plans and activations may keep pointing to them while others register
+     */
+    typedef segmented_table<component_descriptor> id_to_descriptor_map;
 
     /** map component names and unique ids */
     typedef std::map<std::string, unique_id> name_to_id_map;
@@ -430,18 +1277,21 @@ private:
 
 private:
 
-    /** ids to descriptors map */
+    /** ids to descriptors table */
     id_to_descriptor_map _descriptors;
 
     /** name to ids map */
     name_to_id_map _names;
 
+    /** one past the highest id a descriptor was retrieved for */
+    atomic<unique_id> _end;
+
     /* --- Constructor --- */
 
 public:
 
     /** Private - it's a singleton (there's only one registry) */
-    components_registry() { }
+    components_registry() : _end(0) { }
     
     /* --- Public methods and operators --- */
 
@@ -456,6 +1306,21 @@ public:
      */
     component_descriptor& operator[](unique_id component_id);
 
+    /**
+     * Retrieves the component's descriptor, without registering it.
+     *
+     * @param component_id component id
+     * @return component descriptor, or <code>0</code> if the component's not
+     *         found
+     */
+    component_descriptor* find(unique_id component_id);
+
+    /**
+     * @return one past the highest component id descriptors may have been
+     *         registered for
+     */
+    unique_id end() const { return _end.load(memory_order_acquire); }
+
     /**
      * Retrieves the component's descriptor by the component's name.
      *
@@ -27,7 +27,7 @@ namespace inject {
 
 template<int ID>
 template<class From, class To>
-typename context<ID>::unknown_ptr context<ID>::component_cast<From, To>::cast(unknown_ptr instance) {
+void context<ID>::component_cast<From, To>::cast(unknown_ptr& instance) {
 
     // TODO: validate that given pointer instance if a From, and throw bad_cast
     // if not
@@ -36,16 +36,29 @@ typename context<ID>::unknown_ptr context<ID>::component_cast<From, To>::cast(un
     // cast from the implementation to the base is a must - this will also make
     // sure that classes declared as providing a component actually inherit that
     // component (a check done at compile time)
-    return
-        boost::static_pointer_cast<unknown_component>(
-            boost::static_pointer_cast<To>(
-                boost::static_pointer_cast<From>(instance)));
+    instance = pointer_policy::template upcast<From, To>(INJECT_MOVE(instance));
 }
 
 template<int ID>
 typename context<ID>::component_descriptor&
 context<ID>::components_registry::operator[](unique_id component_id) {
-    return _descriptors[component_id];
+    component_descriptor& desc = _descriptors[component_id];
+
+    unique_id end = _end.load(memory_order_relaxed);
+    while (end <= component_id &&
+            !_end.compare_exchange_weak(end, component_id + 1,
+                memory_order_release)) {
+        // another thread raised it meanwhile
+    }
+
+    return desc;
+}
+
+template<int ID>
+typename context<ID>::component_descriptor*
+context<ID>::components_registry::find(unique_id component_id) {
+    return component_id >= 0 && component_id < end() ?
+        _descriptors.find(component_id) : 0;
 }
 
 template<int ID>
@@ -61,10 +74,10 @@ context<ID>::components_registry::operator[](const std::string& name) {
     
 template<int ID>
 void context<ID>::components_registry::unregister(unique_id component_id) {
-    component_descriptor& desc = _descriptors[component_id];
-    if (desc.id != INVALID_ID) {
-        _names.erase(desc.component_name);
-        _descriptors.erase(component_id);
+    component_descriptor* desc = find(component_id);
+    if (desc != 0 && desc->id != INVALID_ID) {
+        _names.erase(desc->component_name);
+        *desc = component_descriptor();
     }
 }
     
@@ -76,19 +89,27 @@ register_name(const std::string& name, unique_id component_id) {
 
 template<int ID>
 context<ID>*& context<ID>::current() {
-    static context<ID>* _current = 0;
+    static INJECT_THREAD_LOCAL context<ID>* _current = 0;
     return _current;
 }
 
 template<int ID>
 context<ID>& context<ID>::get_current() {
-    static context<ID> _global;
-    return (*current());
+    // the global context is only needed by threads without contexts - others
+    // don't pay for its initialization guard
+    context<ID>* current = context<ID>::current();
+    return current != 0 ? *current : global();
+}
+
+template<int ID>
+context<ID>& context<ID>::global() {
+    static context<ID> _global((global_tag()));
+    return _global;
 }
 
 template<int ID>    
 context<ID>*& context<ID>::head() {
-    static context<ID>* _head = 0;
+    static INJECT_THREAD_LOCAL context<ID>* _head = 0;
     return _head;
 }
     
@@ -98,25 +119,174 @@ typename context<ID>::components_registry& context<ID>::registry() {
     return _registry;
 }
 
+template<int ID>
+atomic<unsigned long>& context<ID>::plans_generation() {
+    // starts at 1, so default-constructed plans are never valid
+    static atomic<unsigned long> _generation(1);
+    return _generation;
+}
+
+template<int ID>
+void context<ID>::invalidate_plans() {
+    ++plans_generation();
+}
+
+template<int ID>
+unsigned long context<ID>::generation() const {
+    // both counters only grow, so the sum changes whenever one does
+    return plans_generation().load() + _generation.load();
+}
+
+template<int ID>
+void context<ID>::invalidate_bindings() {
+    ++_generation;
+
+    // children are never locked before their parents
+    scoped_lock lock(_children_lock);
+    for (std::size_t i = 0 ; i < _children.size() ; ++i) {
+        _children[i]->invalidate_bindings();
+    }
+}
+
+template<int ID>
+unsigned long context<ID>::next_serial() {
+    // starts at 1, so zero-initialized thread cache entries are never valid
+    static atomic<unsigned long> _serial(0);
+    return ++_serial;
+}
+
+template<int ID>
+typename context<ID>::waiting_thread* context<ID>::waiting() {
+    static INJECT_THREAD_LOCAL waiting_thread _waiting = { 0 };
+    return &_waiting;
+}
+
+template<int ID>
+mutex& context<ID>::waiting_lock() {
+    static mutex _lock;
+    return _lock;
+}
+
+template<int ID>
+bool context<ID>::take(singleton_slot& slot, unique_id component_id) {
+    waiting_thread* self = waiting();
+    scoped_lock lock(waiting_lock());
+
+    if (slot.owner == 0) {
+        slot.owner = self;
+        self->waiting_for = 0;
+        return true;
+    }
+
+    // waiting for this very thread would never end - and neither would
+    // waiting for a thread that waits for it. nobody waits for a cycle
+    // already, every thread closing one finds it here
+    for (waiting_thread* t = slot.owner ; t != 0 ; ) {
+        if (t == self) {
+            self->waiting_for = 0;
+            throw circular_dependency(component_id);
+        }
+        t = t->waiting_for != 0 ? t->waiting_for->owner : 0;
+    }
+
+    self->waiting_for = &slot;
+    return false;
+}
+
+template<int ID>
+void context<ID>::release(singleton_slot& slot) {
+    {
+        scoped_lock lock(slot.lock);
+        scoped_lock waiting(waiting_lock());
+        slot.owner = 0;
+    }
+
+#ifdef INJECT_HAS_STD_THREADS
+    slot.released.notify_all();
+#endif
+}
+
+template<int ID>
+typename context<ID>::prepared_arguments*& context<ID>::prepared() {
+    static INJECT_THREAD_LOCAL prepared_arguments* _prepared = 0;
+    return _prepared;
+}
+
+#ifdef INJECT_HAS_COROUTINES
+template<int ID>
+typename context<ID>::deferred_initialization*& context<ID>::deferred() {
+    static INJECT_THREAD_LOCAL deferred_initialization* _deferred = 0;
+    return _deferred;
+}
+#endif
+
+template<int ID>
+typename context<ID>::thread_cache_entry* context<ID>::thread_cache() {
+    static INJECT_THREAD_LOCAL thread_cache_entry _cache[thread_cache_size];
+    return _cache;
+}
+
 template<int ID>    
 context<ID>::~context() {
-    // pop <this> from stack
+    // no thread may be reading this context's plans anymore
+    reclaim(ULONG_MAX);
+
+    if (_arena) {
+        // pointers to arena instances must go before the arena does
+        _plans.clear();
+        _singletons.clear();
+        _arena.reset();
+    }
+
+    // pop <this> from this thread's stack
     context<ID>::head() = _parent;
     context<ID>::current() = _parent;
+
+    if (_parent != 0) {
+        scoped_lock lock(_parent->_children_lock);
+        _parent->_children.erase(std::find(_parent->_children.begin(),
+            _parent->_children.end(), this));
+    }
 }
 
 template<int ID>
-context<ID>::context(context_config& config) {
+context<ID>::context(context_config& config) : _generation(0) {
     configure(config);
     init();
 }
 
+template<int ID>
+context<ID>::context(arena_type) :
+    _arena(new instance_arena()),
+    _generation(0) {
+    // arena instances are owned through deleters that do nothing
+    BOOST_STATIC_ASSERT(custom_ownership::value);
+    init();
+}
+
+template<int ID>
+context<ID>::context(global_tag) :
+    _generation(0),
+    _effective_generation(0),
+    _retired(0),
+    _serial(next_serial()),
+    _parent(0) { }
+
 template<int ID>
 void context<ID>::init() {
-    // push <this> to stack and make current
-    _parent = head();
+    _effective_generation = 0;
+    _retired = 0;
+    _serial = next_serial();
+
+    // push <this> to this thread's stack and make current. the global context
+    // is at the bottom of every stack
+    _parent = head() != 0 ? head() : &global();
     context<ID>::head() = this;
     context<ID>::current() = this;
+
+    // the parent's bindings changing invalidates this context's plans
+    scoped_lock lock(_parent->_children_lock);
+    _parent->_children.push_back(this);
 }
 
 template<int ID>
@@ -132,103 +302,568 @@ void context<ID>::configure(context_config& config) {
 template<int ID>
 template<class Interface>
 typename context<ID>::template ptr<Interface>::type context<ID>::instance() {
-    return boost::static_pointer_cast<Interface>(
+    return pointer_policy::template typed<Interface>(
         instance(id_of<Interface>::id()));
 }
 
 template<int ID>
-binding context<ID>::find_binding(unique_id interface_id) {
-    bindings_map::iterator bind_iter = _bindings.find(interface_id);
-    if (bind_iter == _bindings.end()) {
+template<class Interface>
+Interface& context<ID>::singleton() {
+    unique_id interface_id = id_of<Interface>::id();
+
+    {
+        // the plan may be replaced once we're done reading it - the singleton
+        // itself stays in _singletons
+        epoch_guard reading;
+        resolution_plan& p = plan(interface_id);
+
+        if (p.scope != scope_singleton) {
+            throw not_singleton(interface_id);
+        }
+
+        unknown_component* published = p.published.load(memory_order_acquire);
+        if (published != 0) {
+            return *static_cast<Interface*>(published);
+        }
+    }
+
+    // first use - _singletons keeps the instance once the pointer is dropped
+    return *static_cast<Interface*>(instance(interface_id).get());
+}
+
+template<int ID>
+template<class Interface, class OutputIterator>
+OutputIterator context<ID>::instantiate_n(std::size_t n, OutputIterator out) {
+    unique_id interface_id = id_of<Interface>::id();
+    current_guard guard(this);
+
+    component_descriptor* plan_descriptor;
+    generic_component_cast* cast;
+    component_scope scope;
+
+    {
+        // the plan may be replaced once we're done reading it
+        epoch_guard reading;
+        resolution_plan& p = plan(interface_id);
+
+        plan_descriptor = p.descriptor;
+        cast = p.cast;
+        scope = p.scope;
+    }
+
+    component_descriptor& desc = *plan_descriptor;
+
+    if (scope != scope_none || _arena ||
+            desc.allocator.allocate_block == 0) {
+        // scoped instances are shared, and arena instances are cheap -
+        // there's nothing to amortize (or no way to, with this context's
+        // pointers)
+        for ( ; n > 0 ; --n) {
+            *out++ = pointer_policy::template typed<Interface>(
+                resolve(interface_id));
+        }
+        return out;
+    }
+
+    if (n == 0) {
+        return out;
+    }
+
+    if (desc.activating) {
+        throw circular_dependency(desc.id);
+    }
+
+    unknown_ptr block = desc.allocator.allocate_block(n);
+    char* instance = static_cast<char*>(block.get());
+
+    desc.activating = true;
+
+    try {
+        for ( ; n > 0 ; --n, instance += desc.allocator.instance_size) {
+            unknown_ptr activated = desc.activate_in(instance, block);
+            cast->cast(activated);
+            *out++ = pointer_policy::template typed<Interface>(
+                INJECT_MOVE(activated));
+        }
+    } catch (...) {
+        desc.activating = false;
+        throw;
+    }
+
+    desc.activating = false;
+
+    return out;
+}
+
+template<int ID>
+template<class A1, class A2, class A3, class A4, class A5,
+    class A6, class A7, class A8, class A9, class A10>
+typename context<ID>::template
+    instances_of<A1, A2, A3, A4, A5, A6, A7, A8, A9, A10>::type
+context<ID>::instances() {
+    // injected fields of everything activated below use this context
+    current_guard guard(this);
+
+    return typename instances_of<
+        A1, A2, A3, A4, A5, A6, A7, A8, A9, A10>::type(
+        instance_slot<A1>::resolve(*this),
+        instance_slot<A2>::resolve(*this),
+        instance_slot<A3>::resolve(*this),
+        instance_slot<A4>::resolve(*this),
+        instance_slot<A5>::resolve(*this),
+        instance_slot<A6>::resolve(*this),
+        instance_slot<A7>::resolve(*this),
+        instance_slot<A8>::resolve(*this),
+        instance_slot<A9>::resolve(*this),
+        instance_slot<A10>::resolve(*this));
+}
+
+template<int ID>
+template<class A1, class A2, class A3, class A4, class A5,
+    class A6, class A7, class A8, class A9, class A10>
+typename context<ID>::template
+    instances_of<A1, A2, A3, A4, A5, A6, A7, A8, A9, A10>::type
+context<ID>::arguments(unique_id component_id) {
+    prepared_arguments* args = prepared();
+    if (args != 0 && args->component_id == component_id) {
+        // taken - whatever the arguments activate resolves its own
+        prepared() = 0;
+    } else {
+        args = 0;
+    }
+
+    current_guard guard(this);
+
+    return typename instances_of<
+        A1, A2, A3, A4, A5, A6, A7, A8, A9, A10>::type(
+        instance_slot<A1>::take(*this, args, 0),
+        instance_slot<A2>::take(*this, args, 1),
+        instance_slot<A3>::take(*this, args, 2),
+        instance_slot<A4>::take(*this, args, 3),
+        instance_slot<A5>::take(*this, args, 4),
+        instance_slot<A6>::take(*this, args, 5),
+        instance_slot<A7>::take(*this, args, 6),
+        instance_slot<A8>::take(*this, args, 7),
+        instance_slot<A9>::take(*this, args, 8),
+        instance_slot<A10>::take(*this, args, 9));
+}
+
+template<int ID>
+const typename context<ID>::bindings_map& context<ID>::effective_bindings() {
+    unsigned long current = generation();
+    if (_effective_generation != current) {
+        // flatten parent's bindings and ours - chunks we don't override are
+        // shared with the parent, not copied
+        _effective.clear();
         if (_parent != 0) {
-            return _parent->find_binding(interface_id);
-        } else {
-            component_descriptor& desc =
-                registry()[interface_id];
-
-            if (desc.default_binding.what() == interface_id) {
-                return desc.default_binding;
-            } else if (desc.id == INVALID_ID) {
-                throw no_component(interface_id);
-            } else {
-                throw no_binding(interface_id);
+            // the parent may be flattening its own for another thread
+            scoped_lock lock(_parent->_lock);
+            _effective.override_with(_parent->effective_bindings());
+        }
+        _effective.override_with(_bindings);
+        _effective_generation = current;
+    }
+
+    return _effective;
+}
+
+template<int ID>
+binding context<ID>::find_binding(unique_id interface_id) {
+    const binding* bind = effective_bindings().find(interface_id);
+    if (bind != 0) {
+        return *bind;
+    }
+
+    // not bound in this context or any of its parents, use default binding
+    component_descriptor* desc = registry().find(interface_id);
+
+    if (desc != 0 && desc->default_binding.what() == interface_id) {
+        return desc->default_binding;
+    } else if (desc == 0 || desc->id == INVALID_ID) {
+        throw no_component(interface_id);
+    } else {
+        throw no_binding(interface_id);
+    }
+}
+
+template<int ID>
+typename context<ID>::resolution_plan&
+context<ID>::plan(unique_id interface_id) {
+#ifdef INJECT_THREAD_CACHE
+    thread_cache_entry& entry = thread_cache()[
+        (_serial * 31 + static_cast<std::size_t>(interface_id)) &
+        (thread_cache_size - 1)];
+
+    if (entry.serial == _serial &&
+            entry.interface_id == interface_id &&
+            entry.generation == generation()) {
+        return *entry.plan;
+    }
+#endif
+
+    plan_entry* e = _plans.find(interface_id);
+    resolution_plan* p = e != 0 ? e->plan.load(memory_order_acquire) : 0;
+
+    if (p == 0 || p->generation != generation()) {
+        scoped_lock lock(_lock);
+
+        // another thread may have compiled it meanwhile
+        e = &_plans[interface_id];
+        p = e->plan.load(memory_order_relaxed);
+
+        if (p == 0 || p->generation != generation()) {
+            resolution_plan* compiled = compile(interface_id);
+
+            // a binding that didn't change keeps its published singleton
+            if (p != 0 && p->scope == scope_singleton &&
+                    compiled->scope == scope_singleton &&
+                    p->descriptor == compiled->descriptor &&
+                    p->cast == compiled->cast &&
+                    p->published.load(memory_order_acquire) != 0) {
+                compiled->singleton = p->singleton;
+                compiled->published.store(compiled->singleton.get(),
+                    memory_order_relaxed);
+            }
+
+            e->plan.store(compiled, memory_order_release);
+
+            if (p != 0) {
+                // readers may still be using the replaced plan
+                p->retired = epoch::retire();
+                p->next_retired = _retired;
+                _retired = p;
+                reclaim(epoch::oldest_reader());
             }
+
+            p = compiled;
         }
     }
 
-    return bind_iter->second;
+#ifdef INJECT_THREAD_CACHE
+    entry.serial = _serial;
+    entry.interface_id = interface_id;
+    entry.generation = p->generation;
+    entry.plan = p;
+#endif
+
+    return *p;
 }
 
 template<int ID>
-typename context<ID>::unknown_ptr
-context<ID>::instance(unique_id interface_id) {
+void context<ID>::reclaim(unsigned long oldest) {
+    resolution_plan** link = &_retired;
+    while (*link != 0) {
+        resolution_plan* p = *link;
+        if (p->retired < oldest) {
+            *link = p->next_retired;
+            delete p;
+        } else {
+            link = &p->next_retired;
+        }
+    }
+}
+
+template<int ID>
+typename context<ID>::resolution_plan*
+context<ID>::compile(unique_id interface_id) {
+    // bindings changed during compilation are picked up by the next one
+    unsigned long generation = this->generation();
 
     const binding& bind = find_binding(interface_id);
-    component_descriptor& desc = registry()[bind.to()];
+    component_descriptor* desc = registry().find(bind.to());
 
-    if (desc.id == INVALID_ID) {
+    if (desc == 0 || desc->id == INVALID_ID) {
         throw no_binding(interface_id);
     }
     
-    if (desc.allocator == 0) {
-        throw not_providing(desc.id, interface_id);
+    if (desc->allocator.allocate == 0) {
+        throw not_providing(desc->id, interface_id);
     }
-    
-    unknown_ptr instance;
-    typename instances_map::iterator iter;
 
-    // save current "current" context, and set <this> to the current context,
-    // so injected fields will use the context that's being used for
-    // instantiation and not some other unrelated context
-    context<ID>* backup_current = context<ID>::current();
-    context<ID>::current() = this;
+    // find cast provider - a component that can't be cast is never built
+    generic_component_cast** cast = desc->component_cast.find(interface_id);
 
-    // activate instace
-    switch (bind.scope()) {
-    case scope_none:
-        instance = instantiate(desc);
-        break;
-
-    case scope_singleton:
-        iter = _singletons.find(bind.to());
-        if (iter == _singletons.end()) {
-            instance = instantiate(desc);
-            // TODO: register singletons in global context? may cause having
-            // multiple instances in different scopes, or scoping cannot be done
-            // per-context. (same component can be a singleton in one context,
-            // and non-scoped in another...)
-            //
-            // maybe use local binding for scope resolution, but provide
-            // singleton from global context?
-            _singletons[bind.to()] = instance;
-        } else {
-            instance = iter->second;
+    if (cast == 0) {
+        // bound component has an allocator, so it provides something - just
+        // not the interface it is bound to
+        throw not_providing(desc->id, interface_id);
+    }
+
+    // the singleton may have been activated by a previous plan (or through
+    // another interface bound to the same component) - the first resolution
+    // picks it up from _singletons
+    resolution_plan* p = new resolution_plan(generation);
+    p->descriptor = desc;
+    p->cast = *cast;
+    p->scope = bind.scope();
+    return p;
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::instance(unique_id interface_id) {
+    // set <this> as the current context, so injected fields will use the
+    // context that's being used for instantiation and not some other
+    // unrelated context
+    current_guard guard(this);
+    return resolve(interface_id);
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::resolve(unique_id interface_id) {
+
+    component_descriptor* plan_descriptor;
+    generic_component_cast* cast;
+    component_scope scope;
+
+    {
+        // the plan may be replaced once we're done reading it - keep what we
+        // need from it
+        epoch_guard reading;
+        resolution_plan& p = plan(interface_id);
+
+        if (p.scope == scope_singleton &&
+                p.published.load(memory_order_acquire) != 0) {
+            return p.singleton;
         }
-        break;
 
-    default:
-        break;
+        plan_descriptor = p.descriptor;
+        cast = p.cast;
+        scope = p.scope;
     }
 
-    // find cast provider
-    typename component_descriptor::component_cast_map::iterator cast_iter = 
-        desc.component_cast.find(interface_id);
+    component_descriptor& desc = *plan_descriptor;
 
-    if (cast_iter == desc.component_cast.end()) {
-        // TODO: a component that doesn provide that interface was bound to it,
-        //       can this even compile? binding should try and create a cast
-        //       provider, and this should fail compilation...
+    if (scope == scope_singleton) {
+        return share(desc, cast, interface_id);
+    }
+
+    if (scope == scope_pooled) {
+        return lend(desc, cast, interface_id, custom_ownership());
     }
-    
-    // restor current
-    context<ID>::current() = backup_current;
 
-    return cast_iter->second->cast(instance);
+    unknown_ptr instance = instantiate(desc, _arena.get());
+    cast->cast(instance);
+    return instance;
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::share(component_descriptor& desc, generic_component_cast* cast,
+        unique_id interface_id) {
+    // TODO: register singletons in global context? may cause having
+    // multiple instances in different scopes, or scoping cannot be done
+    // per-context. (same component can be a singleton in one context,
+    // and non-scoped in another...)
+    //
+    // maybe use local binding for scope resolution, but provide
+    // singleton from global context?
+    singleton_slot& slot = _singletons[desc.id];
+
+    // only the first resolutions of the component wait here - independent
+    // singletons are activated in parallel
+#ifdef INJECT_HAS_STD_THREADS
+    {
+        std::unique_lock<mutex> lock(slot.lock);
+        while (!take(slot, desc.id)) {
+            slot.released.wait(lock);
+        }
+    }
+#else
+    for (unsigned k = 0 ; ; ++k) {
+        {
+            scoped_lock lock(slot.lock);
+            if (take(slot, desc.id)) {
+                break;
+            }
+        }
+        backoff(k);
+    }
+#endif
+
+    unknown_ptr instance;
+    try {
+        instance = slot.instance;
+        if (instance.get() == 0) {
+            instance = instantiate(desc, _arena.get());
+        }
+
+        slot.instance = instance;
+
+        cast->cast(instance);
+
+        // publish it to the current plan - unless another thread did, or the
+        // interface was rebound meanwhile
+        epoch_guard reading;
+        resolution_plan& p = plan(interface_id);
+
+        if (p.descriptor == &desc && p.scope == scope_singleton &&
+                p.published.load(memory_order_relaxed) == 0) {
+            p.singleton = instance;
+            p.published.store(p.singleton.get(), memory_order_release);
+        }
+    } catch (...) {
+        release(slot);
+        throw;
+    }
+
+    release(slot);
+    return instance;
 }
     
 template<int ID>
 typename context<ID>::unknown_ptr
-context<ID>::instantiate(component_descriptor& desc) {
+context<ID>::component_descriptor::activate() const {
+    unknown_ptr p = allocator.allocate();
+    void* instance = p.get();
+
+    // if construction throws, releasing the pointer gives the memory back -
+    // there's nothing to destroy
+    constructor(instance);
+
+    // from here on, the pointer owns the instance
+    allocator.adopt(instance);
+
+    for (typename activators_list::const_iterator iter = activators.begin();
+            iter != activators.end();
+            ++iter) {
+        (*iter)(instance);
+    }
+
+    initialize(instance);
+
+    return p;
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::lend(component_descriptor& desc, generic_component_cast* cast,
+        unique_id interface_id, boost::true_type) {
+    boost::shared_ptr<instance_pool> pool;
+    {
+        pool_slot& slot = _pools[desc.id];
+        scoped_lock lock(slot.lock);
+        if (slot.pool.get() == 0) {
+            slot.pool.reset(
+                new instance_pool(desc.pool_capacity, desc.reset));
+        }
+        pool = slot.pool;
+    }
+
+    unknown_ptr instance = pool->acquire();
+    if (instance.get() == 0) {
+        // lent instances may outlive the context, so they're never in its
+        // arena
+        instance = instantiate(desc, 0);
+    }
+
+    unknown_ptr lent = instance_pool::lend(pool, instance);
+    cast->cast(lent);
+    return lent;
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::lend(component_descriptor& desc, generic_component_cast* cast,
+        unique_id interface_id, boost::false_type) {
+    // lending requires pointers with custom deleters - not pooled after all
+    unknown_ptr instance = instantiate(desc, _arena.get());
+    cast->cast(instance);
+    return instance;
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::activate(component_descriptor& desc, instance_arena& arena,
+        boost::true_type) {
+    return desc.activate(arena);
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::activate(component_descriptor& desc, instance_arena&,
+        boost::false_type) {
+    // arena contexts can't be constructed with this context's pointers
+    return desc.activate();
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::component_descriptor::activate(instance_arena& arena) const {
+    // if construction throws, the memory is just left unused
+    void* instance = arena.allocate(allocator.instance_size,
+        allocator.instance_alignment);
+    typename instance_arena::destructor* destruction = arena.reserve();
+
+    constructor(instance);
+
+    unknown_ptr p = arena.adopt(instance, allocator.destroy, destruction);
+
+    for (typename activators_list::const_iterator iter = activators.begin();
+            iter != activators.end();
+            ++iter) {
+        (*iter)(instance);
+    }
+
+    initialize(instance);
+
+    return p;
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::component_descriptor::activate_in(void* instance,
+        const unknown_ptr& block) const {
+    // if construction throws, the memory is given back with the block
+    constructor(instance);
+
+    unknown_ptr p = allocator.adopt_in_block(instance, block);
+
+    for (typename activators_list::const_iterator iter = activators.begin();
+            iter != activators.end();
+            ++iter) {
+        (*iter)(instance);
+    }
+
+    initialize(instance);
+
+    return p;
+}
+
+template<int ID>
+void context<ID>::component_descriptor::initialize(void* instance) const {
+#ifdef INJECT_HAS_COROUTINES
+    if (initializer == 0) {
+        return;
+    }
+
+    // inside a coroutine resolution only the component being resolved may
+    // hand its initialization over - waiting for any other could block the
+    // very thread it needs to complete on
+    deferred_initialization* deferred = context<ID>::deferred();
+    bool deferring = deferred != 0 && deferred->component_id == id &&
+        !deferred->initialization.valid();
+    if (deferred != 0 && !deferring) {
+        throw blocking_initialization(id);
+    }
+
+    task<> initialization = initializer(instance);
+
+    if (deferring) {
+        deferred->initialization = std::move(initialization);
+        return;
+    }
+
+    initialization.wait();
+#else
+    (void) instance;
+#endif
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::instantiate(component_descriptor& desc, instance_arena* arena) {
     try {
         if (desc.activating) {
             throw circular_dependency(desc.id);
@@ -236,15 +871,8 @@ context<ID>::instantiate(component_descriptor& desc) {
 
         desc.activating = true;
 
-        unknown_ptr p = desc.allocator->activate(unknown_ptr());
-        p = desc.constructor->activate(p);
-
-        for (typename component_descriptor::activators_list::iterator iter =
-                desc.activators.begin();
-                iter != desc.activators.end();
-                ++iter) {
-            p = (*iter)->activate(p);
-        }
+        unknown_ptr p = arena != 0 ?
+            activate(desc, *arena, custom_ownership()) : desc.activate();
 
         desc.activating = false;
     
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_COUNTED_PTR_H__
+#define __INJECT_COUNTED_PTR_H__
+
+#include <cstddef>
+#include <algorithm>
+
+#include <boost/smart_ptr/detail/atomic_count.hpp>
+
+#include "config.h"
+
+namespace inject {
+
+/**
+ * a reference count which isn't safe to share between threads, for
+ * single-threaded contexts
+ */
+class unsynchronized_count {
+private:
+    long _count;
+public:
+    /** @param count initial count */
+    explicit unsynchronized_count(long count) : _count(count) { }
+
+    /** increments the count */
+    void increment() { ++_count; }
+
+    /** @return count after decrementing it */
+    long decrement() { return --_count; }
+};
+
+/**
+ * a reference count which is safe to share between threads
+ */
+class synchronized_count {
+private:
+    boost::detail::atomic_count _count;
+public:
+    /** @param count initial count */
+    explicit synchronized_count(long count) : _count(count) { }
+
+    /** increments the count */
+    void increment() { ++_count; }
+
+    /** @return count after decrementing it */
+    long decrement() { return --_count; }
+};
+
+/**
+ * the header inject places in front of every instance owned by intrusive
+ * pointers - the instance immediately follows it
+ *
+ * @tparam Counter reference count type
+ */
+template<class Counter>
+struct counted_header {
+    /** releases the instance - called when the count drops to zero */
+    typedef void (*release_function)(counted_header<Counter>* header);
+
+    Counter count;
+    release_function release;
+
+    /** @param release releases the instance */
+    explicit counted_header(release_function release) :
+        count(1), release(release) { }
+
+    /** @return the instance following the header */
+    void* instance() {
+        return reinterpret_cast<char*>(this) + sizeof(counted_header<Counter>);
+    }
+
+    /**
+     * @param instance instance following a header
+     * @return the header
+     */
+    static counted_header<Counter>* of(void* instance) {
+        return reinterpret_cast<counted_header<Counter>*>(
+            static_cast<char*>(instance) - sizeof(counted_header<Counter>));
+    }
+
+    /** @param header header to add a reference to, may be null */
+    static void add_ref(counted_header<Counter>* header) {
+        if (header != 0) {
+            header->count.increment();
+        }
+    }
+
+    /** @param header header to drop a reference from, may be null */
+    static void drop_ref(counted_header<Counter>* header) {
+        if (header != 0 && header->count.decrement() == 0) {
+            header->release(header);
+        }
+    }
+};
+
+/**
+ * an untyped intrusive pointer, used internally by contexts. since the
+ * pointed-to object may be a base of the instance (at some offset), the
+ * header is kept alongside
+ *
+ * @tparam Counter reference count type
+ */
+template<class Counter>
+class counted_handle {
+private:
+    typedef counted_header<Counter> header_type;
+private:
+    void* _p;
+    header_type* _header;
+public:
+    counted_handle() : _p(0), _header(0) { }
+
+    /**
+     * @param p pointer to the instance, or to a base of it
+     * @param header the instance's header
+     * @param add_ref whether to add a reference, or to take over one
+     */
+    counted_handle(void* p, header_type* header, bool add_ref) :
+            _p(p), _header(header) {
+        if (add_ref) {
+            header_type::add_ref(_header);
+        }
+    }
+
+    counted_handle(const counted_handle<Counter>& other) :
+            _p(other._p), _header(other._header) {
+        header_type::add_ref(_header);
+    }
+
+    ~counted_handle() {
+        header_type::drop_ref(_header);
+    }
+
+    counted_handle<Counter>& operator=(const counted_handle<Counter>& other) {
+        counted_handle<Counter>(other).swap(*this);
+        return *this;
+    }
+
+#ifdef INJECT_HAS_RVALUE_REFERENCES
+    counted_handle(counted_handle<Counter>&& other) :
+            _p(other._p), _header(other._header) {
+        other._p = 0;
+        other._header = 0;
+    }
+
+    counted_handle<Counter>& operator=(counted_handle<Counter>&& other) {
+        counted_handle<Counter>(std::move(other)).swap(*this);
+        return *this;
+    }
+#endif
+
+    void* get() const { return _p; }
+
+    /** @return the instance's header */
+    header_type* header() const { return _header; }
+
+    /**
+     * empties the handle, without dropping its reference
+     * @return the header the reference is kept in
+     */
+    header_type* release() {
+        header_type* header = _header;
+        _p = 0;
+        _header = 0;
+        return header;
+    }
+
+    void reset() {
+        counted_handle<Counter>().swap(*this);
+    }
+
+    void swap(counted_handle<Counter>& other) {
+        std::swap(_p, other._p);
+        std::swap(_header, other._header);
+    }
+};
+
+/**
+ * an intrusive pointer to an instance allocated by an
+ * <code>intrusive_ptr_policy</code> context. the reference count is kept in a
+ * header in front of the instance - the pointer keeps the header along, since
+ * <code>T</code> may be a base of the instance (at some offset), so no
+ * reference count change has to find it.
+ *
+ * @tparam T pointed-to type
+ * @tparam Counter reference count type
+ */
+template<class T, class Counter>
+class counted_ptr {
+private:
+    typedef counted_header<Counter> header_type;
+    typedef void (counted_ptr<T, Counter>::*safe_bool)();
+private:
+    T* _p;
+    header_type* _header;
+public:
+    counted_ptr() : _p(0), _header(0) { }
+
+    /**
+     * @param p pointer to an instance, or to a base of it
+     * @param header the instance's header
+     * @param add_ref whether to add a reference, or to take over one
+     */
+    counted_ptr(T* p, header_type* header, bool add_ref) :
+            _p(p), _header(header) {
+        if (add_ref) {
+            header_type::add_ref(_header);
+        }
+    }
+
+    counted_ptr(const counted_ptr<T, Counter>& other) :
+            _p(other._p), _header(other._header) {
+        header_type::add_ref(_header);
+    }
+
+    /** @param other pointer to a type convertible to <code>T</code> */
+    template<class U>
+    counted_ptr(const counted_ptr<U, Counter>& other) :
+            _p(other.get()), _header(other.header()) {
+        header_type::add_ref(_header);
+    }
+
+#ifdef INJECT_HAS_RVALUE_REFERENCES
+    counted_ptr(counted_ptr<T, Counter>&& other) :
+            _p(other._p), _header(other._header) {
+        other._p = 0;
+        other._header = 0;
+    }
+
+    counted_ptr<T, Counter>& operator=(counted_ptr<T, Counter>&& other) {
+        counted_ptr<T, Counter>(std::move(other)).swap(*this);
+        return *this;
+    }
+#endif
+
+    ~counted_ptr() {
+        header_type::drop_ref(_header);
+    }
+
+    counted_ptr<T, Counter>& operator=(const counted_ptr<T, Counter>& other) {
+        counted_ptr<T, Counter>(other).swap(*this);
+        return *this;
+    }
+
+    T* get() const { return _p; }
+    T& operator*() const { return *_p; }
+    T* operator->() const { return _p; }
+
+    operator safe_bool() const {
+        return _p != 0 ? &counted_ptr<T, Counter>::reset : 0;
+    }
+
+    bool operator!() const { return _p == 0; }
+
+    void reset() {
+        counted_ptr<T, Counter>().swap(*this);
+    }
+
+    void swap(counted_ptr<T, Counter>& other) {
+        std::swap(_p, other._p);
+        std::swap(_header, other._header);
+    }
+
+    /** @return the instance's header, or null */
+    header_type* header() const { return _header; }
+};
+
+template<class T, class U, class Counter>
+bool operator==(const counted_ptr<T, Counter>& a,
+        const counted_ptr<U, Counter>& b) {
+    return a.get() == b.get();
+}
+
+template<class T, class U, class Counter>
+bool operator!=(const counted_ptr<T, Counter>& a,
+        const counted_ptr<U, Counter>& b) {
+    return a.get() != b.get();
+}
+
+template<class T, class U, class Counter>
+bool operator<(const counted_ptr<T, Counter>& a,
+        const counted_ptr<U, Counter>& b) {
+    return a.get() < b.get();
+}
+
+} // namespace inject
+
+#endif // __INJECT_COUNTED_PTR_H__
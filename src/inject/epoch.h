@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_EPOCH_H__
+#define __INJECT_EPOCH_H__
+
+#include "config.h"
+#include "sync.h"
+
+namespace inject {
+
+/**
+ * epoch-based reclamation: readers announce the epoch they started reading
+ * in, without locking or waiting, and objects unpublished by writers are only
+ * reclaimed once every reader that could still see them is done.
+ *
+ * writers unpublish an object, stamp it with {@link retire()} and later
+ * reclaim it once its stamp is older than {@link oldest_reader()}.
+ */
+class epoch {
+public:
+    /**
+     * enters a read-side section on the calling thread. sections nest - only
+     * the outermost announces an epoch
+     */
+    static void enter() {
+        record* r = this_thread();
+        if (r->depth++ == 0) {
+            // released like leaving - writers that see either know what the
+            // thread did before
+            r->epoch.store(current().load(memory_order_relaxed),
+                memory_order_release);
+
+            // announce before reading anything published
+            atomic_thread_fence(memory_order_seq_cst);
+        }
+    }
+
+    /** leaves a read-side section on the calling thread */
+    static void leave() {
+        record* r = this_thread();
+        if (--r->depth == 0) {
+            r->epoch.store(0, memory_order_release);
+        }
+    }
+
+    /**
+     * call after unpublishing an object
+     * @return stamp of the object - it may be reclaimed once the stamp is
+     *         older than {@link oldest_reader()}
+     */
+    static unsigned long retire() {
+        return current()++;
+    }
+
+    /**
+     * @return oldest epoch a reader is still reading in, or the current epoch
+     *         if no reader is
+     */
+    static unsigned long oldest_reader() {
+        // see the announcements of readers that may have missed the unpublish
+        atomic_thread_fence(memory_order_seq_cst);
+
+        unsigned long oldest = current().load(memory_order_relaxed);
+        for (record* r = records().load(memory_order_acquire) ;
+                r != 0 ;
+                r = r->next) {
+            unsigned long e = r->epoch.load(memory_order_acquire);
+            if (e != 0 && e < oldest) {
+                oldest = e;
+            }
+        }
+
+        return oldest;
+    }
+private:
+    /**
+     * a reader thread's announcement. records are never freed - a thread
+     * that exits leaves its record to the next one
+     */
+    struct record {
+        record() : epoch(0), in_use(true), depth(0), next(0) { }
+
+        /** epoch the thread is reading in, or <code>0</code> if it isn't */
+        atomic<unsigned long> epoch;
+        atomic<bool> in_use;
+
+        /** nesting depth of read-side sections - private to the thread */
+        unsigned long depth;
+
+        record* next;
+    };
+
+#if __cplusplus >= 201103L
+    /** gives the thread's record back when the thread exits */
+    struct record_owner {
+        record* owned;
+
+        ~record_owner() {
+            if (owned != 0) {
+                owned->in_use.store(false, memory_order_release);
+            }
+        }
+    };
+#endif
+
+    static atomic<unsigned long>& current() {
+        // starts at 1 - 0 means "not reading"
+        static atomic<unsigned long> _epoch(1);
+        return _epoch;
+    }
+
+    static atomic<record*>& records() {
+        static atomic<record*> _records(0);
+        return _records;
+    }
+
+    static record* this_thread() {
+        static INJECT_THREAD_LOCAL record* _record = 0;
+        if (_record == 0) {
+            _record = acquire_record();
+#if __cplusplus >= 201103L
+            static thread_local record_owner _owner = { 0 };
+            _owner.owned = _record;
+#endif
+        }
+        return _record;
+    }
+
+    static record* acquire_record() {
+        // reuse the record of an exited thread if there is one
+        for (record* r = records().load(memory_order_acquire) ;
+                r != 0 ;
+                r = r->next) {
+            bool in_use = false;
+            if (!r->in_use.load(memory_order_relaxed) &&
+                    r->in_use.compare_exchange_strong(in_use, true)) {
+                return r;
+            }
+        }
+
+        record* r = new record();
+        r->next = records().load(memory_order_relaxed);
+        while (!records().compare_exchange_weak(r->next, r)) { }
+        return r;
+    }
+};
+
+/**
+ * a read-side section, for the scope of the guard
+ */
+class epoch_guard {
+public:
+    epoch_guard() { epoch::enter(); }
+    ~epoch_guard() { epoch::leave(); }
+private: // disallow copy-ctor and assign operator
+    epoch_guard(const epoch_guard&);
+    epoch_guard& operator=(const epoch_guard&);
+};
+
+} // namespace inject
+
+#endif // __INJECT_EPOCH_H__
@@ -192,6 +192,77 @@ public:
     }
 };
 
+/**
+ * thrown when a component with an initialization coroutine is activated
+ * inside {@link context::co_instance} by other means than as a constructor
+ * argument - waiting for it there could deadlock the thread running the
+ * coroutines
+ */
+class blocking_initialization : public std::exception {
+private:
+    unique_id _component;
+    std::string _msg;
+public:
+    /**
+     * @param component component whose initialization would block
+     */
+    blocking_initialization(unique_id component) throw() :
+            exception(), _component(component) {
+        std::stringstream oss;
+        oss << "initialization of component " << component <<
+            " would block a coroutine resolution";
+        _msg = oss.str();
+    }
+
+    virtual ~blocking_initialization() throw() { }
+
+    /**
+     * @return exception message
+     */
+    virtual const char* what() const throw() { return _msg.c_str(); }
+
+    /**
+     * @return id of component whose initialization would block
+     */
+    virtual const unique_id component() const throw() {
+        return _component;
+    }
+};
+
+/**
+ * thrown when a component is borrowed, but isn't bound as a singleton in the
+ * context - only singletons live as long as the context
+ */
+class not_singleton : public std::exception {
+private:
+    unique_id _component;
+    std::string _msg;
+public:
+    /**
+     * @param component component that isn't bound as a singleton
+     */
+    not_singleton(unique_id component) throw() :
+            exception(), _component(component) {
+        std::stringstream oss;
+        oss << "component " << component << " isn't bound as a singleton";
+        _msg = oss.str();
+    }
+
+    virtual ~not_singleton() throw() { }
+
+    /**
+     * @return exception message
+     */
+    virtual const char* what() const throw() { return _msg.c_str(); }
+
+    /**
+     * @return id of component that isn't bound as a singleton
+     */
+    virtual const unique_id component() const throw() {
+        return _component;
+    }
+};
+
 } // namespace inject
 
 #endif // __INJECT_EXCEPTIONS_H__
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_EXECUTOR_H__
+#define __INJECT_EXECUTOR_H__
+
+#include "config.h"
+
+#ifdef INJECT_HAS_STD_THREADS
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace inject {
+
+/**
+ * runs background work on a bounded number of threads, shared by every
+ * context. a worker that needs the result of a job that didn't start yet runs
+ * it itself - so jobs may wait for the jobs they submit without running out of
+ * threads.
+ */
+class executor {
+private:
+    /** a submitted job - run once, by a worker or by the first to need it */
+    class job {
+    public:
+        virtual ~job() { }
+
+        /** runs the job, unless it already ran (or is running) */
+        void run() {
+            if (!_taken.exchange(true)) {
+                execute();
+            }
+        }
+    protected:
+        job() : _taken(false) { }
+
+        virtual void execute() = 0;
+    private:
+        std::atomic<bool> _taken;
+    };
+
+    /** @tparam T result type */
+    template<class T>
+    class typed_job : public job {
+    public:
+        explicit typed_job(std::function<T()> f) :
+            _task(std::move(f)),
+            _result(_task.get_future().share()) { }
+
+        const std::shared_future<T>& result() const { return _result; }
+    protected:
+        void execute() { _task(); }
+    private:
+        std::packaged_task<T()> _task;
+        std::shared_future<T> _result;
+    };
+private:
+    std::mutex _lock;
+
+    /** signalled when a job is queued, or when stopping */
+    std::condition_variable _queued;
+
+    /** jobs no worker took yet - some may have been run by who needed them */
+    std::deque< std::shared_ptr<job> > _jobs;
+
+    bool _stopping;
+    std::vector<std::thread> _workers;
+public:
+    /**
+     * the result of a submitted job
+     * @tparam T result type
+     */
+    template<class T>
+    class ticket {
+    private:
+        std::shared_ptr< typed_job<T> > _job;
+    public:
+        ticket() { }
+
+        explicit ticket(const std::shared_ptr< typed_job<T> >& job) :
+            _job(job) { }
+
+        /** @return whether there's a job to wait for */
+        bool valid() const { return _job != 0; }
+
+        /**
+         * waits for the job - running it on the calling thread first if it's
+         * a worker and the job didn't start yet
+         * @return the job's result
+         * @throws whatever the job threw
+         */
+        auto get() const ->
+                decltype(std::declval<const std::shared_future<T>&>().get()) {
+            if (current() != 0) {
+                _job->run();
+            }
+            return _job->result().get();
+        }
+    };
+
+    /**
+     * @param threads number of workers
+     */
+    explicit executor(unsigned threads) : _stopping(false) {
+        for (unsigned i = 0 ; i < threads ; ++i) {
+            _workers.push_back(std::thread([this] { work(); }));
+        }
+    }
+
+    /** waits for the running jobs - the ones that didn't start never do */
+    ~executor() {
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _stopping = true;
+        }
+        _queued.notify_all();
+
+        for (std::size_t i = 0 ; i < _workers.size() ; ++i) {
+            _workers[i].join();
+        }
+    }
+
+    /** @return the executor shared by every context, one worker per core */
+    static executor& shared() {
+        static executor _shared(
+            std::max(2u, std::thread::hardware_concurrency()));
+        return _shared;
+    }
+
+    /**
+     * @param f work to run on a worker
+     * @return the result of <code>f</code>, once it ran
+     */
+    template<class T>
+    ticket<T> submit(std::function<T()> f) {
+        std::shared_ptr< typed_job<T> > submitted =
+            std::make_shared< typed_job<T> >(std::move(f));
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _jobs.push_back(submitted);
+        }
+        _queued.notify_one();
+
+        return ticket<T>(submitted);
+    }
+private:
+    /** @return the executor the calling thread works for, if any */
+    static executor*& current() {
+        static thread_local executor* _current = 0;
+        return _current;
+    }
+
+    void work() {
+        current() = this;
+
+        std::unique_lock<std::mutex> guard(_lock);
+        for (;;) {
+            _queued.wait(guard, [this] {
+                return _stopping || !_jobs.empty();
+            });
+
+            if (_stopping) {
+                return;
+            }
+
+            std::shared_ptr<job> next = _jobs.front();
+            _jobs.pop_front();
+
+            guard.unlock();
+            next->run();
+            next.reset();
+            guard.lock();
+        }
+    }
+private: // non-copyable
+    executor(const executor&);
+    executor& operator=(const executor&);
+};
+
+} // namespace inject
+
+#endif // INJECT_HAS_STD_THREADS
+
+#endif // __INJECT_EXECUTOR_H__
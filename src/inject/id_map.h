@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_ID_MAP_H__
+#define __INJECT_ID_MAP_H__
+
+#include <cstddef>
+#include <vector>
+
+#include "id_of.h"
+
+namespace inject {
+
+/**
+ * a flat, open-addressing hash table keyed by {@link unique_id}. entries are
+ * stored inline in a single array and collisions are resolved by linear
+ * probing, so a lookup usually touches one or two cache lines instead of
+ * chasing tree nodes across the heap.
+ *
+ * @tparam Value mapped type. must be default-constructible and assignable
+ *
+ * @note inserting may relocate all entries - pointers and references to values
+ *       are invalidated by <code>operator[]</code> and <code>erase</code>
+ * @note {@link INVALID_ID} marks an empty slot and cannot be used as a key
+ */
+template<class Value>
+class id_map {
+private: // types
+    struct slot {
+        slot() : key(INVALID_ID), value() { }
+
+        unique_id key;
+        Value value;
+    };
+
+    typedef std::vector<slot> slots_vector;
+private: // members
+    slots_vector _slots;
+    std::size_t _size;
+    std::size_t _mask;
+public: // constructors
+    /** constructs an empty map */
+    id_map() : _slots(), _size(0), _mask(0) { }
+public: // methods
+    /**
+     * retrieves the value mapped to the given key, or inserts a
+     * default-constructed value if the key is not found, and returns it.
+     * @param key key to look up
+     * @return mapped value
+     */
+    Value& operator[](unique_id key);
+
+    /**
+     * @param key key to look up
+     * @return pointer to mapped value, or <code>0</code> if key is not found
+     */
+    Value* find(unique_id key);
+
+    /**
+     * @param key key to look up
+     * @return pointer to mapped value, or <code>0</code> if key is not found
+     */
+    const Value* find(unique_id key) const;
+
+    /**
+     * removes a key and its mapped value
+     * @param key key to remove
+     * @return whether the key was found
+     */
+    bool erase(unique_id key);
+
+    /** removes all entries */
+    void clear();
+
+    /** @return number of entries */
+    std::size_t size() const { return _size; }
+
+    /** @return whether there are no entries */
+    bool empty() const { return _size == 0; }
+private:
+    /** number of slots allocated on first insert, must be a power of two */
+    static const std::size_t min_capacity = 8;
+
+    std::size_t home_of(unique_id key) const;
+    std::size_t index_of(unique_id key) const;
+    void grow();
+};
+
+} // namespace inject
+
+#include "id_map.inl"
+
+#endif // __INJECT_ID_MAP_H__
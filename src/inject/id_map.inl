@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_ID_MAP_INL__
+#define __INJECT_ID_MAP_INL__
+
+#include <assert.h>
+
+namespace inject {
+
+template<class Value>
+std::size_t id_map<Value>::home_of(unique_id key) const {
+    // fibonacci hashing - identifiers are handed out sequentially, multiplying
+    // by the golden ratio spreads neighbouring keys across the table
+    std::size_t h = static_cast<std::size_t>(key) * 2654435769UL;
+    return (h ^ (h >> 16)) & _mask;
+}
+
+template<class Value>
+std::size_t id_map<Value>::index_of(unique_id key) const {
+    std::size_t i = home_of(key);
+    while (_slots[i].key != key && _slots[i].key != INVALID_ID) {
+        i = (i + 1) & _mask;
+    }
+    return i;
+}
+
+template<class Value>
+Value& id_map<Value>::operator[](unique_id key) {
+    assert(key != INVALID_ID);
+
+    // nothing is allocated until the first insert
+    if (_slots.empty()) {
+        grow();
+    }
+
+    std::size_t i = index_of(key);
+    if (_slots[i].key == key) {
+        return _slots[i].value;
+    }
+
+    // keep load factor at most 1/2, so probe sequences stay short
+    if ((_size + 1) * 2 > _slots.size()) {
+        grow();
+        i = index_of(key);
+    }
+
+    _slots[i].key = key;
+    ++_size;
+    return _slots[i].value;
+}
+
+template<class Value>
+Value* id_map<Value>::find(unique_id key) {
+    if (_slots.empty()) {
+        return 0;
+    }
+
+    std::size_t i = index_of(key);
+    return _slots[i].key == key && key != INVALID_ID ? &_slots[i].value : 0;
+}
+
+template<class Value>
+const Value* id_map<Value>::find(unique_id key) const {
+    if (_slots.empty()) {
+        return 0;
+    }
+
+    std::size_t i = index_of(key);
+    return _slots[i].key == key && key != INVALID_ID ? &_slots[i].value : 0;
+}
+
+template<class Value>
+bool id_map<Value>::erase(unique_id key) {
+    if (_slots.empty()) {
+        return false;
+    }
+
+    std::size_t hole = index_of(key);
+    if (_slots[hole].key != key || key == INVALID_ID) {
+        return false;
+    }
+
+    // backward-shift deletion: move following entries of the probe sequence
+    // into the hole, so no tombstones are needed
+    std::size_t i = hole;
+    for (;;) {
+        i = (i + 1) & _mask;
+        if (_slots[i].key == INVALID_ID) {
+            break;
+        }
+
+        std::size_t home = home_of(_slots[i].key);
+
+        // entry may move to the hole only if the hole is cyclically between
+        // its home slot and its current slot
+        if (((i - home) & _mask) >= ((i - hole) & _mask)) {
+            _slots[hole] = _slots[i];
+            hole = i;
+        }
+    }
+
+    _slots[hole] = slot();
+    --_size;
+    return true;
+}
+
+template<class Value>
+void id_map<Value>::clear() {
+    slots_vector().swap(_slots);
+    _size = 0;
+    _mask = 0;
+}
+
+template<class Value>
+void id_map<Value>::grow() {
+    slots_vector old(_slots.empty() ? min_capacity : _slots.size() * 2);
+    old.swap(_slots);
+    _mask = _slots.size() - 1;
+
+    for (typename slots_vector::iterator iter = old.begin();
+            iter != old.end();
+            ++iter) {
+        if (iter->key != INVALID_ID) {
+            _slots[index_of(iter->key)] = *iter;
+        }
+    }
+}
+
+} // namespace inject
+
+#endif // __INJECT_ID_MAP_INL__
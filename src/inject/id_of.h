@@ -25,12 +25,14 @@
 
 #include <cstddef>
 
+#include "sync.h"
+
 namespace inject {
 
 /**
- * we use pointer arithmetics to identify types, to allow the same type to
- * appear in two different dynamic modules without a collision. See comment
- * inside monotonic_counter::next_unique_id for further details
+ * types are identified by dense, sequential integers starting at 0, so the
+ * context can index its tables by them directly. See comment inside
+ * monotonic_counter::next_unique_id regarding dynamic modules
  */
 typedef std::ptrdiff_t unique_id;
 
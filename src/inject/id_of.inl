@@ -29,7 +29,6 @@ namespace inject {
  * a monotonic counter
  * @tparam T ignored, used as a workaround to avoid a cpp file
  * @note do not use this class - it is an internal implementation detail
- * @note this class is not thread safe
  */
 template<typename T = void>
 class monotonic_counter {
@@ -41,13 +40,10 @@ public:
         // monotonic_counters in the system, we could use inject across module
         // boundaries
 
-        // the counter begins at the address of unique_id_counter to partially
-        // address the issue above. this way there's smaller chance of
-        // identifier overlap across module boundaries (though this still
-        // doesn't guarantee uniqueness) since each module should have a
-        // different memory location for this counter
-        static unique_id unique_id_counter =
-            reinterpret_cast<unique_id>(&unique_id_counter);
+        // the counter begins at 0, so identifiers are dense and can be used as
+        // table indices. note that each module has its own counter, so
+        // identifiers of different modules overlap
+        static atomic<unique_id> unique_id_counter(0);
 
         return unique_id_counter++;
     }
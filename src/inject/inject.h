@@ -23,15 +23,30 @@
 #ifndef __INJECT_INJECT_H__
 #define __INJECT_INJECT_H__
 
+#include "config.h"
 #include "binding.h"
+#include "binding_table.h"
 #include "component.h"
 #include "context_config.h"
 #include "context.h"
+#include "counted_ptr.h"
 #include "debug.h"
 #include "exceptions.h"
+#include "executor.h"
 #include "id_of.h"
+#include "id_map.h"
 #include "injected.h"
+#include "pointer_policy.h"
+#include "pool.h"
+#include "segmented_table.h"
+#include "singleton_ref.h"
+#include "static_context.h"
+#include "sync.h"
+#include "task.h"
 #include "types.h"
 #include "activator.h"
+#include "arena.h"
+#include "async.h"
+#include "warm_up.h"
 
 #endif // __INJECT_INJECTED_H__
@@ -24,6 +24,7 @@
 #define __INJECT_INJECTED_H__
 
 #include "context.h"
+#include "executor.h"
 #include "types.h"
 
 namespace inject {
@@ -31,6 +32,11 @@ namespace inject {
 class lazy_type {};
 static lazy_type lazy;
 
+#ifdef INJECT_HAS_STD_THREADS
+class speculative_type {};
+static const speculative_type speculative = speculative_type();
+#endif
+
 /**
  * obtains the component implementing <code>T</code> from the current context.
  * simply constructing this pointer-wrapper is enough to obtain the pointer.
@@ -56,6 +62,11 @@ private:
 private:
     ptr_type _ptr;
 
+#ifdef INJECT_HAS_STD_THREADS
+    /** construction started in the background, until it's first needed */
+    executor::ticket<ptr_type> _pending;
+#endif
+
 public:
 
     /**
@@ -72,8 +83,25 @@ public:
      */
     injected(const lazy_type&) {}
 
+#ifdef INJECT_HAS_STD_THREADS
+    /**
+     * obtain component speculatively - it's constructed in the background
+     * right away, on the shared {@link executor}, and the first time it is
+     * needed waits only if it isn't done yet - or constructs it, if it didn't
+     * start and this is a worker. the current context must outlive the
+     * construction. an arena context isn't shared between threads, so with
+     * one it's obtained lazily instead.
+     */
+    injected(const speculative_type&) :
+        _pending(speculate(context<ID>::get_current())) { }
+
+    /** @param other copy from */
+    injected(const injected<T>& other) :
+        _ptr(other._ptr), _pending(other._pending) { }
+#else
     /** @param other copy from */
     injected(const injected<T>& other) : _ptr(other._ptr) { }
+#endif
 
     /**
      * @param ptr pointer to wrap
@@ -86,6 +114,9 @@ public:
      */
     injected<T>& operator=(const injected<T>& other) {
         _ptr = other._ptr;
+#ifdef INJECT_HAS_STD_THREADS
+        _pending = other._pending;
+#endif
         return (*this);
     }
 
@@ -105,11 +136,17 @@ public:
         return !((*this) == other);
     }
 
-    /** @return instance pointer by wrapper pointer */
-    T& operator*() const throw() { return (*ptr()); }
+    /**
+     * @return instance pointer by wrapper pointer
+     * @throws whatever resolving it throws, if it's lazy or speculative
+     */
+    T& operator*() const { return (*ptr()); }
 
-    /** @return wrapper pointer */
-    T* operator->() const throw() { return ptr().get(); }
+    /**
+     * @return wrapper pointer
+     * @throws whatever resolving it throws, if it's lazy or speculative
+     */
+    T* operator->() const { return ptr().get(); }
 
     /** @return wrapper pointer */
     T* get() { return ptr().get(); }
@@ -130,18 +167,41 @@ public:
 private:
     ptr_type& ptr() {
       if (_ptr.get() == 0) {
+#ifdef INJECT_HAS_STD_THREADS
+        if (_pending.valid()) {
+          // the next one to need it asks the context, even if this fails
+          executor::ticket<ptr_type> pending = _pending;
+          _pending = executor::ticket<ptr_type>();
+          _ptr = pending.get();
+          return _ptr;
+        }
+#endif
         _ptr = context<ID>::get_current().template instance<T>();
       }
       return _ptr;
     }
 
     const ptr_type& ptr() const {
-      if (_ptr.get() == 0) {
-        *const_cast<ptr_type*>(&_ptr) =
-          context<ID>::get_current().template instance<T>();
-      }
-      return _ptr;
+      return const_cast<injected<T>*>(this)->ptr();
+    }
+
+#ifdef INJECT_HAS_STD_THREADS
+    /**
+     * @param c context to construct the component in
+     * @return the construction, submitted to the shared executor - none if
+     *         <code>c</code> is arena-backed
+     */
+    static executor::ticket<ptr_type> speculate(context<ID>& c) {
+        if (c._arena) {
+            return executor::ticket<ptr_type>();
+        }
+
+        return executor::shared().submit<ptr_type>([&c] {
+            return pointer_policy::template typed<T>(
+                c.instance_prepared(id_of<T>::id()));
+        });
     }
+#endif
 };
 
 } // namespace inject
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_POINTER_POLICY_H__
+#define __INJECT_POINTER_POLICY_H__
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+
+#include "config.h"
+#include "types.h"
+#include "counted_ptr.h"
+
+namespace inject {
+
+/**
+ * the pointers a context hands out are <code>boost::shared_ptr</code>. the
+ * default policy.
+ */
+struct shared_ptr_policy {
+    /** @tparam T pointed-to type */
+    template<class T>
+    struct pointer {
+        typedef boost::shared_ptr<T> type;
+    };
+
+    /** untyped pointer */
+    typedef pointer<unknown_component>::type unknown_ptr;
+
+    /**
+     * pointers can own through any deleter - required by pooled bindings,
+     * arena contexts and bulk instantiation
+     */
+    typedef boost::true_type custom_ownership;
+
+    /**
+     * @param p pointer to an instance of <code>From</code>
+     * @return untyped pointer to the <code>To</code> base of the instance,
+     *         sharing ownership with <code>p</code>
+     */
+    template<class From, class To>
+    static unknown_ptr upcast(const unknown_ptr& p) {
+        return unknown_ptr(p, static_cast<unknown_component*>(
+            static_cast<To*>(static_cast<From*>(p.get()))));
+    }
+
+    /**
+     * @param p untyped pointer to a <code>T</code>
+     * @return typed pointer, sharing ownership with <code>p</code>
+     */
+    template<class T>
+    static typename pointer<T>::type typed(const unknown_ptr& p) {
+        return boost::static_pointer_cast<T>(p);
+    }
+
+#ifdef INJECT_HAS_RVALUE_REFERENCES
+    /** @see upcast - takes over <code>p</code>'s ownership */
+    template<class From, class To>
+    static unknown_ptr upcast(unknown_ptr&& p) {
+        unknown_component* to = static_cast<To*>(static_cast<From*>(p.get()));
+        return unknown_ptr(std::move(p), to);
+    }
+
+    /** @see typed - takes over <code>p</code>'s ownership */
+    template<class T>
+    static typename pointer<T>::type typed(unknown_ptr&& p) {
+        return boost::static_pointer_cast<T>(std::move(p));
+    }
+#endif
+
+    /**
+     * allocates instances along with their reference count, in a single
+     * allocation (the way <code>boost::allocate_shared</code> does)
+     *
+     * @tparam Allocator allocator to use
+     * @tparam Activated allocated type
+     */
+    template<class Allocator, class Activated>
+    class storage {
+    private:
+        /**
+         * storage of an instance. the instance is destroyed with the storage
+         * only once it's adopted
+         */
+        struct holder {
+            /** the instance - first, so its address is the holder's */
+            typename boost::aligned_storage<sizeof(Activated),
+                boost::alignment_of<Activated>::value>::type storage;
+
+            /** whether the instance was constructed and adopted */
+            bool adopted;
+
+            holder() : adopted(false) { }
+
+            ~holder() {
+                if (adopted) {
+                    reinterpret_cast<Activated*>(&storage)->~Activated();
+                }
+            }
+        };
+
+        typedef typename rebind_allocator<Allocator, holder>::type
+            holder_allocator;
+    public:
+        /**
+         * @return pointer to an allocated, uninitialized, instance. releasing
+         *         it deallocates the instance, and destroys it once it's
+         *         adopted
+         */
+        static unknown_ptr allocate() {
+            boost::shared_ptr<holder> h =
+                boost::allocate_shared<holder>(holder_allocator());
+            void* instance = &h->storage;
+
+            // point at the instance, sharing the holder's reference count
+            return unknown_ptr(INJECT_MOVE(h), instance);
+        }
+
+        /** @param instance constructed instance, returned by allocate() */
+        static void adopt(void* instance) {
+            reinterpret_cast<holder*>(instance)->adopted = true;
+        }
+    };
+};
+
+/**
+ * the pointers a context hands out are <code>counted_ptr</code> - with the
+ * reference count in a header inject places in front of every instance, which
+ * the pointer keeps along.
+ *
+ * pooled bindings, arena contexts and bulk instantiation rely on custom
+ * deleters, which intrusive pointers don't have: with this policy, pooled
+ * bindings behave as <code>scope_none</code>, bulk instantiation creates one
+ * instance at a time, and arena contexts are not available.
+ *
+ * @tparam Counter reference count type - <code>synchronized_count</code>, or
+ *         <code>unsynchronized_count</code> for single-threaded contexts
+ */
+template<class Counter = synchronized_count>
+struct intrusive_ptr_policy {
+    /** @tparam T pointed-to type */
+    template<class T, class Unused = void>
+    struct pointer {
+        typedef counted_ptr<T, Counter> type;
+    };
+
+    /** untyped pointers keep the header, since they may point to a base */
+    template<class Unused>
+    struct pointer<unknown_component, Unused> {
+        typedef counted_handle<Counter> type;
+    };
+
+    /** untyped pointer */
+    typedef counted_handle<Counter> unknown_ptr;
+
+    /** pointers can't own through deleters */
+    typedef boost::false_type custom_ownership;
+
+    /** @see shared_ptr_policy::upcast */
+    template<class From, class To>
+    static unknown_ptr upcast(const unknown_ptr& p) {
+        return unknown_ptr(static_cast<unknown_component*>(
+            static_cast<To*>(static_cast<From*>(p.get()))), p.header(), true);
+    }
+
+    /** @see shared_ptr_policy::typed */
+    template<class T>
+    static typename pointer<T>::type typed(const unknown_ptr& p) {
+        return typename pointer<T>::type(static_cast<T*>(p.get()), p.header(),
+            true);
+    }
+
+#ifdef INJECT_HAS_RVALUE_REFERENCES
+    /** @see shared_ptr_policy::upcast - takes over <code>p</code>'s reference */
+    template<class From, class To>
+    static unknown_ptr upcast(unknown_ptr&& p) {
+        unknown_component* to = static_cast<To*>(static_cast<From*>(p.get()));
+        return unknown_ptr(to, p.release(), false);
+    }
+
+    /** @see shared_ptr_policy::typed - takes over <code>p</code>'s reference */
+    template<class T>
+    static typename pointer<T>::type typed(unknown_ptr&& p) {
+        T* typed = static_cast<T*>(p.get());
+        return typename pointer<T>::type(typed, p.release(), false);
+    }
+#endif
+
+    /**
+     * allocates instances along with the header, in a single allocation
+     *
+     * @tparam Allocator allocator to use
+     * @tparam Activated allocated type
+     */
+    template<class Allocator, class Activated>
+    class storage {
+    private:
+        typedef counted_header<Counter> header_type;
+
+        // the instance must immediately follow the header
+        BOOST_STATIC_ASSERT(sizeof(header_type) %
+            boost::alignment_of<Activated>::value == 0);
+
+        /** the header, followed by the instance */
+        struct holder {
+            header_type header;
+            typename boost::aligned_storage<sizeof(Activated),
+                boost::alignment_of<Activated>::value>::type storage;
+        };
+
+        typedef typename rebind_allocator<Allocator, holder>::type
+            holder_allocator;
+
+        /** deallocates an instance which was never adopted */
+        static void deallocate(header_type* header) {
+            holder* h = reinterpret_cast<holder*>(header);
+            h->header.~header_type();
+
+            holder_allocator al;
+            al.deallocate(h, 1);
+        }
+
+        /** destroys and deallocates an adopted instance */
+        static void destroy(header_type* header) {
+            static_cast<Activated*>(header->instance())->~Activated();
+            deallocate(header);
+        }
+    public:
+        /** @see shared_ptr_policy::storage::allocate */
+        static unknown_ptr allocate() {
+            holder_allocator al;
+            holder* h = al.allocate(1);
+            new(&h->header) header_type(&deallocate);
+
+            // takes over the header's initial reference
+            return unknown_ptr(&h->storage, &h->header, false);
+        }
+
+        /** @see shared_ptr_policy::storage::adopt */
+        static void adopt(void* instance) {
+            header_type::of(instance)->release = &destroy;
+        }
+    };
+};
+
+/**
+ * per-context settings. specialize before the context is used to change them,
+ * e.g.:
+ *
+ * @code
+ * namespace inject {
+ * template<>
+ * struct context_traits<1> {
+ *     typedef intrusive_ptr_policy<unsynchronized_count> pointer_policy;
+ * };
+ * }
+ * @endcode
+ *
+ * @tparam ID context ID
+ */
+template<int ID>
+struct context_traits {
+    /** the kind of pointers the context hands out */
+    typedef shared_ptr_policy pointer_policy;
+};
+
+} // namespace inject
+
+#endif // __INJECT_POINTER_POLICY_H__
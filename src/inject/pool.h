@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_POOL_H__
+#define __INJECT_POOL_H__
+
+#include <vector>
+
+#include "context.h"
+#include "sync.h"
+
+namespace inject {
+
+/**
+ * a bounded free list of idle instances of a component, used for
+ * <code>scope_pooled</code> bindings. the pool lends its instances through
+ * pointers which give the instance back to the pool when released, instead of
+ * destroying it.
+ *
+ * the pool is owned by the context and by every pointer it lent, so lent
+ * instances may outlive the context. the memory of the lent pointers' control
+ * blocks is recycled as well, so reacquiring an idle instance allocates
+ * nothing. threads may acquire and release instances concurrently.
+ *
+ * @tparam ID context ID
+ */
+template<int ID>
+class context<ID>::instance_pool {
+private:
+    typedef typename component_descriptor::activate_function reset_function;
+    typedef boost::shared_ptr<instance_pool> pool_ptr;
+
+    class lent_deleter;
+
+    template<class U>
+    class block_allocator;
+private:
+    /** owning pointers to idle instances */
+    std::vector<unknown_ptr> _idle;
+
+    /** memory of released control blocks, all of the same size */
+    std::vector<void*> _blocks;
+
+    /** maximal number of idle instances (and cached control blocks) */
+    std::size_t _capacity;
+
+    /** called on an instance before it becomes idle - may be null */
+    reset_function _reset;
+
+    /** held while using <code>_idle</code> or <code>_blocks</code> */
+    mutex _lock;
+private: // non-copyable
+    instance_pool(const instance_pool&);
+    instance_pool& operator=(const instance_pool&);
+public:
+    /**
+     * @param capacity maximal number of idle instances
+     * @param reset called on an instance before it becomes idle - may be null
+     */
+    instance_pool(std::size_t capacity, reset_function reset);
+
+    /** destroys the idle instances */
+    ~instance_pool();
+
+    /**
+     * @return owning pointer to an idle instance, which is no longer idle, or
+     *         an empty pointer if there are none
+     */
+    unknown_ptr acquire();
+
+    /**
+     * @param pool the pool to lend through
+     * @param instance owning pointer to an instance
+     * @return pointer to the instance, which gives it back to the pool when
+     *         released
+     */
+    static unknown_ptr lend(const pool_ptr& pool, const unknown_ptr& instance);
+private:
+    /**
+     * resets an instance, and keeps it as an idle instance if there's room.
+     * otherwise, or if resetting fails, the instance is released
+     * @param instance owning pointer to a released instance
+     */
+    void recycle(unknown_ptr& instance);
+
+    void* allocate_block(std::size_t size);
+    void deallocate_block(void* block);
+};
+
+/**
+ * the deleter of lent pointers - gives the instance back to its pool
+ */
+template<int ID>
+class context<ID>::instance_pool::lent_deleter {
+private:
+    pool_ptr _pool;
+    unknown_ptr _instance;
+public:
+    lent_deleter(const pool_ptr& pool, const unknown_ptr& instance) :
+        _pool(pool), _instance(instance) { }
+
+    void operator()(void*) {
+        _pool->recycle(_instance);
+    }
+};
+
+/**
+ * allocates the control blocks of lent pointers from their pool. holds the
+ * pool, so it's still there when the control block is deallocated
+ *
+ * @tparam U allocated type
+ */
+template<int ID>
+template<class U>
+class context<ID>::instance_pool::block_allocator {
+public:
+    typedef U value_type;
+    typedef U* pointer;
+    typedef const U* const_pointer;
+    typedef U& reference;
+    typedef const U& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<class V>
+    struct rebind {
+        typedef block_allocator<V> other;
+    };
+private:
+    pool_ptr _pool;
+public:
+    explicit block_allocator(const pool_ptr& pool) : _pool(pool) { }
+
+    template<class V>
+    block_allocator(const block_allocator<V>& other) : _pool(other.pool()) { }
+
+    /** @return the pool blocks are allocated from */
+    const pool_ptr& pool() const { return _pool; }
+
+    U* allocate(std::size_t n, const void* = 0) {
+        if (n != 1) {
+            return static_cast<U*>(::operator new(sizeof(U) * n));
+        }
+        return static_cast<U*>(_pool->allocate_block(sizeof(U)));
+    }
+
+    void deallocate(U* p, std::size_t n) {
+        if (n != 1) {
+            ::operator delete(p);
+            return;
+        }
+        _pool->deallocate_block(p);
+    }
+
+    void construct(U* p, const U& value) { new(p) U(value); }
+    void destroy(U* p) { p->~U(); }
+
+    std::size_t max_size() const throw() { return std::size_t(-1) / sizeof(U); }
+
+    template<class V>
+    bool operator==(const block_allocator<V>& other) const {
+        return _pool == other.pool();
+    }
+
+    template<class V>
+    bool operator!=(const block_allocator<V>& other) const {
+        return _pool != other.pool();
+    }
+};
+
+} // namespace inject
+
+#include "pool.inl"
+
+#endif // __INJECT_POOL_H__
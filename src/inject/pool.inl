@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_POOL_INL__
+#define __INJECT_POOL_INL__
+
+namespace inject {
+
+template<int ID>
+context<ID>::instance_pool::instance_pool(std::size_t capacity,
+        reset_function reset) :
+    _capacity(capacity),
+    _reset(reset) {
+}
+
+template<int ID>
+context<ID>::instance_pool::~instance_pool() {
+    for (std::vector<void*>::iterator iter = _blocks.begin();
+            iter != _blocks.end();
+            ++iter) {
+        ::operator delete(*iter);
+    }
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr context<ID>::instance_pool::acquire() {
+    unknown_ptr instance;
+
+    scoped_lock lock(_lock);
+    if (!_idle.empty()) {
+        instance.swap(_idle.back());
+        _idle.pop_back();
+    }
+
+    return instance;
+}
+
+template<int ID>
+typename context<ID>::unknown_ptr
+context<ID>::instance_pool::lend(const pool_ptr& pool,
+        const unknown_ptr& instance) {
+    return unknown_ptr(
+        instance.get(),
+        lent_deleter(pool, instance),
+        block_allocator<char>(pool));
+}
+
+template<int ID>
+void context<ID>::instance_pool::recycle(unknown_ptr& instance) {
+    bool room;
+    {
+        scoped_lock lock(_lock);
+        room = _idle.size() < _capacity;
+    }
+
+    if (room) {
+        try {
+            // resetting runs the component's code - not under the lock
+            if (_reset != 0) {
+                _reset(instance.get());
+            }
+
+            // another thread may have taken the room meanwhile
+            scoped_lock lock(_lock);
+            if (_idle.size() < _capacity) {
+                _idle.push_back(unknown_ptr());
+                _idle.back().swap(instance);
+            }
+        } catch (...) {
+            // an instance that can't be reset isn't reused
+        }
+    }
+
+    // released (if not kept) outside the lock, since it may be destroyed
+    instance.reset();
+}
+
+template<int ID>
+void* context<ID>::instance_pool::allocate_block(std::size_t size) {
+    {
+        scoped_lock lock(_lock);
+        if (!_blocks.empty()) {
+            void* block = _blocks.back();
+            _blocks.pop_back();
+            return block;
+        }
+    }
+
+    return ::operator new(size);
+}
+
+template<int ID>
+void context<ID>::instance_pool::deallocate_block(void* block) {
+    try {
+        scoped_lock lock(_lock);
+        if (_blocks.size() < _capacity) {
+            _blocks.push_back(block);
+            return;
+        }
+    } catch (...) {
+        // no room - just free it
+    }
+
+    ::operator delete(block);
+}
+
+} // namespace inject
+
+#endif // __INJECT_POOL_INL__
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_SEGMENTED_TABLE_H__
+#define __INJECT_SEGMENTED_TABLE_H__
+
+#include <cstddef>
+
+#include "id_of.h"
+#include "sync.h"
+
+namespace inject {
+
+/**
+ * a table indexed by {@link unique_id}, whose entries never move. it is made
+ * of segments of doubling sizes, allocated as higher identifiers are used -
+ * so references to entries stay valid while the table grows, and looking an
+ * entry up takes no lock, even while another thread adds a segment.
+ *
+ * @tparam Value entry type. must be default-constructible
+ *
+ * @note <code>clear</code> and destruction must not race with other calls
+ */
+template<class Value>
+class segmented_table {
+private: // members
+    /** number of entries of the first segment */
+    static const std::size_t first_segment_size = 32;
+
+    /** enough segments for any identifier in use */
+    static const std::size_t max_segments = 32;
+
+    atomic<Value*> _segments[max_segments];
+
+    /** held while adding a segment */
+    mutex _lock;
+public: // constructors
+    /** constructs an empty table */
+    segmented_table();
+
+    ~segmented_table();
+public: // methods
+    /**
+     * retrieves the entry of the given identifier, adding a segment of
+     * default-constructed entries if needed
+     * @param id identifier to look up
+     * @return the entry
+     */
+    Value& operator[](unique_id id);
+
+    /**
+     * @param id identifier to look up
+     * @return pointer to entry, or <code>0</code> if its segment wasn't added
+     */
+    Value* find(unique_id id) const;
+
+    /** destroys all entries */
+    void clear();
+private:
+    static std::size_t locate(unique_id id, std::size_t& offset);
+private: // disallow copy-ctor and assign operator
+    segmented_table(const segmented_table<Value>&);
+    segmented_table<Value>& operator=(const segmented_table<Value>&);
+};
+
+} // namespace inject
+
+#include "segmented_table.inl"
+
+#endif // __INJECT_SEGMENTED_TABLE_H__
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_SEGMENTED_TABLE_INL__
+#define __INJECT_SEGMENTED_TABLE_INL__
+
+#include <assert.h>
+
+namespace inject {
+
+template<class Value>
+segmented_table<Value>::segmented_table() {
+    for (std::size_t i = 0 ; i < max_segments ; ++i) {
+        _segments[i].store(0, memory_order_relaxed);
+    }
+}
+
+template<class Value>
+segmented_table<Value>::~segmented_table() {
+    clear();
+}
+
+template<class Value>
+std::size_t segmented_table<Value>::locate(unique_id id, std::size_t& offset) {
+    assert(id != INVALID_ID);
+
+    // identifiers are dense - most of them fall in the first segment
+    std::size_t index = static_cast<std::size_t>(id);
+    std::size_t size = first_segment_size;
+    std::size_t segment = 0;
+    while (index >= size) {
+        index -= size;
+        size <<= 1;
+        ++segment;
+    }
+
+    assert(segment < max_segments);
+    offset = index;
+    return segment;
+}
+
+template<class Value>
+Value& segmented_table<Value>::operator[](unique_id id) {
+    std::size_t offset;
+    std::size_t segment = locate(id, offset);
+
+    Value* entries = _segments[segment].load(memory_order_acquire);
+    if (entries == 0) {
+        scoped_lock lock(_lock);
+
+        // another thread may have added it meanwhile
+        entries = _segments[segment].load(memory_order_relaxed);
+        if (entries == 0) {
+            entries = new Value[first_segment_size << segment];
+            _segments[segment].store(entries, memory_order_release);
+        }
+    }
+
+    return entries[offset];
+}
+
+template<class Value>
+Value* segmented_table<Value>::find(unique_id id) const {
+    std::size_t offset;
+    std::size_t segment = locate(id, offset);
+
+    Value* entries = _segments[segment].load(memory_order_acquire);
+    return entries != 0 ? entries + offset : 0;
+}
+
+template<class Value>
+void segmented_table<Value>::clear() {
+    for (std::size_t i = 0 ; i < max_segments ; ++i) {
+        delete[] _segments[i].load(memory_order_relaxed);
+        _segments[i].store(0, memory_order_relaxed);
+    }
+}
+
+} // namespace inject
+
+#endif // __INJECT_SEGMENTED_TABLE_INL__
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_SINGLETON_REF_H__
+#define __INJECT_SINGLETON_REF_H__
+
+#include "context.h"
+
+namespace inject {
+
+/**
+ * borrows the singleton implementing <code>T</code> from the current context.
+ * unlike {@link context::injected}, no reference is taken - neither when
+ * obtaining the singleton nor when copying this wrapper - since the context
+ * keeps its singletons alive for as long as it lives. it must not outlive the
+ * context. obtaining it reads the context's plan (see
+ * {@link context::singleton}), copying and using it touches no atomics.
+ *
+ * @tparam ID context ID to borrow from
+ * @tparam T component type to borrow - must be bound as a singleton
+ *
+ * Example:
+ * @code
+ * singleton_ref<logger> log;
+ * log->write("hello");
+ * @endcode
+ */
+template<int ID>
+template<class T>
+class context<ID>::singleton_ref {
+private:
+    T* _ptr;
+
+public:
+
+    /**
+     * @throws no_component
+     * @throws no_binding
+     * @throws not_providing
+     * @throws not_singleton
+     * @throws circular_dependency
+     */
+    singleton_ref() :
+        _ptr(&context<ID>::get_current().template singleton<T>()) { }
+
+    /** @param ctx context to borrow from */
+    explicit singleton_ref(context<ID>& ctx) :
+        _ptr(&ctx.template singleton<T>()) { }
+
+    /** @return borrowed instance */
+    T& operator*() const throw() { return *_ptr; }
+
+    /** @return borrowed instance */
+    T* operator->() const throw() { return _ptr; }
+
+    /** @return borrowed instance */
+    T* get() const throw() { return _ptr; }
+};
+
+} // namespace inject
+
+#endif // __INJECT_SINGLETON_REF_H__
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_STATIC_CONTEXT_H__
+#define __INJECT_STATIC_CONTEXT_H__
+
+#include <memory>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "types.h"
+#include "injected.h"
+
+namespace inject {
+
+/**
+ * a binding known at compile time, for use with {@link static_context}
+ *
+ * @tparam Interface interface bound
+ * @tparam Impl implementing type. must derive from <code>Interface</code> (or
+ *         be it), and have a public default constructor
+ * @tparam Scope binding scope (default: none)
+ * @tparam Allocator allocator to allocate <code>Impl</code> instances with -
+ *         should behave like <code>std::allocator</code>
+ */
+template<
+    class Interface,
+    class Impl,
+    component_scope Scope = scope_none,
+    class Allocator = std::allocator<void> >
+struct static_binding {
+    /** interface bound */
+    typedef Interface interface_type;
+
+    /** implementing type */
+    typedef Impl implementation_type;
+
+    /** allocator of implementing type */
+    typedef typename rebind_allocator<Allocator, Impl>::type allocator_type;
+
+    /** binding scope */
+    static const component_scope scope = Scope;
+};
+
+/**
+ * finds the binding of <code>Interface</code> in a list of bindings
+ * @note do not use this class - it is an internal implementation detail
+ */
+template<
+    class Interface,
+    class B1,
+    class B2,
+    class B3,
+    class B4,
+    class B5,
+    class B6,
+    class B7,
+    class B8,
+    class B9,
+    class B10>
+struct static_binding_of :
+    static_binding_of<Interface, B2, B3, B4, B5, B6, B7, B8, B9, B10, void> {
+};
+
+template<
+    class Interface,
+    class Impl,
+    component_scope Scope,
+    class Allocator,
+    class B2,
+    class B3,
+    class B4,
+    class B5,
+    class B6,
+    class B7,
+    class B8,
+    class B9,
+    class B10>
+struct static_binding_of<
+        Interface,
+        static_binding<Interface, Impl, Scope, Allocator>,
+        B2, B3, B4, B5, B6, B7, B8, B9, B10> {
+    typedef static_binding<Interface, Impl, Scope, Allocator> type;
+};
+
+/**
+ * end of bindings list - <code>Interface</code> isn't bound. left undefined, so
+ * requesting an unbound interface fails compilation
+ */
+template<class Interface>
+struct static_binding_of<
+    Interface, void, void, void, void, void, void, void, void, void, void>;
+
+/**
+ * an injection context whose bindings are all known at compile time. it lives
+ * alongside the runtime {@link context}, for the parts of an application whose
+ * wiring never changes - there's no registry, no component ids and no casts,
+ * and obtaining an instance compiles down to allocating and constructing the
+ * implementation (or returning the singleton).
+ *
+ * components don't have to be declared - a binding is all that's needed.
+ * implementations are default-constructed, and may obtain their own
+ * dependencies through {@link static_context::injected} members (or through a
+ * runtime context's {@link context::injected} members, when moving components
+ * to a static context one at a time).
+ *
+ * requesting an interface which isn't bound fails compilation.
+ *
+ * @tparam B1 first binding, a {@link static_binding}
+ * @tparam B2 second binding (optional)
+ * @tparam B3 third binding (optional)
+ * @tparam B4 fourth binding (optional)
+ * @tparam B5 fifth binding (optional)
+ * @tparam B6 sixth binding (optional)
+ * @tparam B7 seventh binding (optional)
+ * @tparam B8 eighth binding (optional)
+ * @tparam B9 ninth binding (optional)
+ * @tparam B10 tenth binding (optional)
+ *
+ * Example:
+ * @code
+ * typedef static_context<
+ *     static_binding<service, service_impl>,
+ *     static_binding<logger, logger_impl, scope_singleton>
+ * > wiring;
+ *
+ * wiring::ptr<service>::type s = wiring::instance<service>();
+ * wiring::injected<logger> l;
+ * @endcode
+ */
+template<
+    class B1,
+    class B2=void,
+    class B3=void,
+    class B4=void,
+    class B5=void,
+    class B6=void,
+    class B7=void,
+    class B8=void,
+    class B9=void,
+    class B10=void>
+class static_context {
+public: // component pointer type
+    /**
+     * always <code>boost::shared_ptr</code> - a static context has no ID, so no
+     * {@link context_traits} to pick another. matches runtime contexts using
+     * the default {@link shared_ptr_policy} only
+     */
+    template<class T>
+    struct ptr {
+        /** the pointer type */
+        typedef boost::shared_ptr<T> type;
+    };
+private: // types
+    template<class Interface>
+    struct binding_of {
+        typedef typename static_binding_of<Interface,
+            B1, B2, B3, B4, B5, B6, B7, B8, B9, B10>::type type;
+    };
+
+    template<class Binding, component_scope Scope = Binding::scope>
+    struct activator;
+public: // classes
+    template<class T>
+    class injected;
+public: // static methods
+    /**
+     * @return pointer to an instance of the implementation bound to
+     *         <code>Interface</code>
+     * @tparam Interface type to obtain pointer to
+     */
+    template<class Interface>
+    static typename ptr<Interface>::type instance() {
+        return activator<typename binding_of<Interface>::type>::activate();
+    }
+};
+
+/**
+ * creates a new implementation instance on every activation
+ */
+template<class B1, class B2, class B3, class B4, class B5,
+    class B6, class B7, class B8, class B9, class B10>
+template<class Binding, component_scope Scope>
+struct static_context<B1, B2, B3, B4, B5, B6, B7, B8, B9, B10>::activator {
+    typedef typename Binding::implementation_type impl_type;
+
+    static typename ptr<impl_type>::type activate() {
+        return boost::allocate_shared<impl_type>(
+            typename Binding::allocator_type());
+    }
+};
+
+/**
+ * creates the implementation instance on first activation, and returns it on
+ * every activation
+ */
+template<class B1, class B2, class B3, class B4, class B5,
+    class B6, class B7, class B8, class B9, class B10>
+template<class Binding>
+struct static_context<B1, B2, B3, B4, B5, B6, B7, B8, B9, B10>::
+activator<Binding, scope_singleton> {
+    typedef typename Binding::implementation_type impl_type;
+
+    static const typename ptr<impl_type>::type& activate() {
+        static typename ptr<impl_type>::type _instance =
+            activator<Binding, scope_none>::activate();
+        return _instance;
+    }
+};
+
+/**
+ * obtains the implementation of <code>T</code> from a static context. the
+ * static counterpart of {@link context::injected}
+ *
+ * @tparam T interface type to obtain implementation for
+ */
+template<class B1, class B2, class B3, class B4, class B5,
+    class B6, class B7, class B8, class B9, class B10>
+template<class T>
+class static_context<B1, B2, B3, B4, B5, B6, B7, B8, B9, B10>::injected {
+private:
+    typedef typename ptr<T>::type ptr_type;
+
+private:
+    mutable ptr_type _ptr;
+
+public:
+    /** obtain implementation at construction time */
+    injected() : _ptr(instance<T>()) { }
+
+    /**
+     * obtain implementation lazily - i.e., only the first time it is needed,
+     * and not at construction time.
+     */
+    injected(const lazy_type&) { }
+
+    /** @return instance pointer by wrapper pointer */
+    T& operator*() const { return (*ptr()); }
+
+    /** @return wrapper pointer */
+    T* operator->() const { return ptr().get(); }
+
+    /** @return wrapper pointer */
+    T* get() const { return ptr().get(); }
+
+    /** @return implicit cast to wrapper pointer type */
+    operator const ptr_type&() const { return ptr(); }
+
+private:
+    const ptr_type& ptr() const {
+        if (_ptr.get() == 0) {
+            _ptr = instance<T>();
+        }
+        return _ptr;
+    }
+};
+
+} // namespace inject
+
+#endif // __INJECT_STATIC_CONTEXT_H__
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_SYNC_H__
+#define __INJECT_SYNC_H__
+
+#include "config.h"
+
+#ifdef INJECT_HAS_STD_THREADS
+    #include <atomic>
+    #include <chrono>
+    #include <mutex>
+    #include <thread>
+#else
+    #include <boost/atomic.hpp>
+    #include <boost/detail/lightweight_mutex.hpp>
+    #include <boost/smart_ptr/detail/yield_k.hpp>
+#endif
+
+namespace inject {
+
+/*
+ * synchronization primitives - the standard library's where available,
+ * boost's otherwise. both provide the same interface
+ */
+#ifdef INJECT_HAS_STD_THREADS
+using std::atomic;
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::memory_order_seq_cst;
+using std::atomic_thread_fence;
+
+typedef std::mutex mutex;
+typedef std::lock_guard<std::mutex> scoped_lock;
+#else
+using boost::atomic;
+using boost::memory_order_relaxed;
+using boost::memory_order_acquire;
+using boost::memory_order_release;
+using boost::memory_order_seq_cst;
+using boost::atomic_thread_fence;
+
+typedef boost::detail::lightweight_mutex mutex;
+typedef boost::detail::lightweight_mutex::scoped_lock scoped_lock;
+#endif
+
+/**
+ * lets other threads run, while the calling thread waits for one of them
+ * @param k number of times the thread already waited for the same thing
+ */
+inline void backoff(unsigned k) {
+#ifdef INJECT_HAS_STD_THREADS
+    if (k < 16) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+#else
+    boost::detail::yield(k);
+#endif
+}
+
+} // namespace inject
+
+#endif // __INJECT_SYNC_H__
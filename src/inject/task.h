@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_TASK_H__
+#define __INJECT_TASK_H__
+
+#include "config.h"
+
+#ifdef INJECT_HAS_COROUTINES
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace inject {
+
+template<class T = void>
+class task;
+
+namespace detail {
+
+/**
+ * a thread blocked until a task completes
+ */
+struct task_waiter {
+    std::mutex lock;
+    std::condition_variable completed;
+    bool done = false;
+};
+
+/**
+ * state shared by the promises of all tasks: who's waiting for the task to
+ * complete, and how it failed
+ */
+class task_promise_base {
+public:
+    /** completes the task, resuming whoever waits for it */
+    struct final_awaiter {
+        bool await_ready() noexcept { return false; }
+
+        template<class Promise>
+        std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<Promise> finished) noexcept {
+            task_promise_base& promise = finished.promise();
+            void* waiting = promise._waiting.exchange(&promise,
+                std::memory_order_acq_rel);
+
+            if (waiting == 0) {
+                return std::noop_coroutine();
+            }
+
+            std::uintptr_t tagged = reinterpret_cast<std::uintptr_t>(waiting);
+            if (tagged & 1) {
+                // the waiter may go away as soon as it's notified
+                task_waiter& waiter =
+                    *reinterpret_cast<task_waiter*>(tagged & ~std::uintptr_t(1));
+                std::lock_guard<std::mutex> guard(waiter.lock);
+                waiter.done = true;
+                waiter.completed.notify_one();
+                return std::noop_coroutine();
+            }
+
+            return std::coroutine_handle<>::from_address(waiting);
+        }
+
+        void await_resume() noexcept { }
+    };
+
+    /** tasks start running as soon as they're called */
+    std::suspend_never initial_suspend() noexcept { return {}; }
+
+    final_awaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { _failure = std::current_exception(); }
+
+    /** @return whether the task completed */
+    bool done() const {
+        return _waiting.load(std::memory_order_acquire) == this;
+    }
+
+    /**
+     * resumes the given coroutine once the task completes
+     * @return <code>false</code> if the task had already completed
+     */
+    bool resume_on_completion(std::coroutine_handle<> awaiting) {
+        void* expected = 0;
+        return _waiting.compare_exchange_strong(expected, awaiting.address(),
+            std::memory_order_acq_rel);
+    }
+
+    /** blocks the calling thread until the task completes */
+    void wait() {
+        task_waiter waiter;
+        void* expected = 0;
+        void* tagged = reinterpret_cast<void*>(
+            reinterpret_cast<std::uintptr_t>(&waiter) | 1);
+
+        if (_waiting.compare_exchange_strong(expected, tagged,
+                std::memory_order_acq_rel)) {
+            std::unique_lock<std::mutex> guard(waiter.lock);
+            waiter.completed.wait(guard, [&waiter] { return waiter.done; });
+        }
+    }
+
+    /** rethrows the exception the task failed with, if any */
+    void rethrow() {
+        if (_failure) {
+            std::rethrow_exception(_failure);
+        }
+    }
+
+private:
+    /**
+     * the promise itself once completed, the awaiting coroutine, or a blocked
+     * thread's waiter (tagged by its lowest bit) - or <code>0</code>
+     */
+    std::atomic<void*> _waiting{0};
+
+    /** exception the task failed with */
+    std::exception_ptr _failure;
+};
+
+template<class T>
+class task_promise : public task_promise_base {
+public:
+    task<T> get_return_object();
+
+    template<class U>
+    void return_value(U&& value) { _value.emplace(std::forward<U>(value)); }
+
+    /** @return the task's result, moved out of it */
+    T result() {
+        rethrow();
+        return std::move(*_value);
+    }
+
+private:
+    std::optional<T> _value;
+};
+
+template<>
+class task_promise<void> : public task_promise_base {
+public:
+    task<void> get_return_object();
+
+    void return_void() { }
+
+    void result() { rethrow(); }
+};
+
+} // namespace detail
+
+/**
+ * the result of a coroutine taking part in activating components. the
+ * coroutine starts running as soon as it's called, and runs until it first
+ * suspends - the task completes when it returns.
+ *
+ * a task may be <code>co_await</code>ed by one coroutine, or waited for by
+ * one thread, and must not be destroyed before it completes.
+ *
+ * @tparam T result of the coroutine
+ */
+template<class T>
+class task {
+public:
+    typedef detail::task_promise<T> promise_type;
+
+    task() : _coroutine() { }
+
+    explicit task(std::coroutine_handle<promise_type> coroutine) :
+        _coroutine(coroutine) { }
+
+    task(task&& other) noexcept :
+        _coroutine(std::exchange(other._coroutine, nullptr)) { }
+
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            _coroutine = std::exchange(other._coroutine, nullptr);
+        }
+        return *this;
+    }
+
+    ~task() { destroy(); }
+
+    /** @return whether there's a coroutine behind the task */
+    bool valid() const { return static_cast<bool>(_coroutine); }
+
+    /** @return whether the coroutine returned (or threw) */
+    bool done() const { return _coroutine.promise().done(); }
+
+    /**
+     * blocks the calling thread until the coroutine completes - it must be
+     * resumed by some other thread meanwhile
+     * @return the coroutine's result
+     * @throws the exception the coroutine threw
+     */
+    T wait() {
+        _coroutine.promise().wait();
+        return _coroutine.promise().result();
+    }
+
+    /** suspends a coroutine until the task completes */
+    struct awaiter {
+        std::coroutine_handle<promise_type> coroutine;
+
+        bool await_ready() const { return coroutine.promise().done(); }
+
+        bool await_suspend(std::coroutine_handle<> awaiting) {
+            return coroutine.promise().resume_on_completion(awaiting);
+        }
+
+        T await_resume() { return coroutine.promise().result(); }
+    };
+
+    awaiter operator co_await() { return awaiter{_coroutine}; }
+
+private:
+    void destroy() {
+        if (_coroutine) {
+            _coroutine.destroy();
+        }
+    }
+
+    task(const task&);
+    task& operator=(const task&);
+
+    std::coroutine_handle<promise_type> _coroutine;
+};
+
+namespace detail {
+
+template<class T>
+task<T> task_promise<T>::get_return_object() {
+    return task<T>(std::coroutine_handle<task_promise<T> >::from_promise(*this));
+}
+
+inline task<void> task_promise<void>::get_return_object() {
+    return task<void>(
+        std::coroutine_handle<task_promise<void> >::from_promise(*this));
+}
+
+} // namespace detail
+
+} // namespace inject
+
+#endif // INJECT_HAS_COROUTINES
+
+#endif // __INJECT_TASK_H__
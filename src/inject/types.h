@@ -23,6 +23,9 @@
 #ifndef __INJECT_TYPES_H__
 #define __INJECT_TYPES_H__
 
+#include <memory>
+
+#include "config.h"
 
 namespace inject {
 
@@ -30,7 +33,33 @@ typedef void unknown_component;
 
 enum component_scope {
     scope_none,
-    scope_singleton
+    scope_singleton,
+    scope_pooled
+};
+
+/**
+ * selects the arena-backed context constructor - instances created by such a
+ * context are bump-allocated, and released all at once with the context
+ */
+enum arena_type {
+    arena
+};
+
+/**
+ * the type an allocator of some type rebinds to, for allocating another
+ * (std::allocator has no nested rebind since C++20 - allocator_traits does it)
+ *
+ * @tparam Allocator allocator to rebind
+ * @tparam T type to allocate
+ */
+template<class Allocator, class T>
+struct rebind_allocator {
+#ifdef INJECT_HAS_ALLOCATOR_TRAITS
+    typedef typename std::allocator_traits<Allocator>::template
+        rebind_alloc<T> type;
+#else
+    typedef typename Allocator::template rebind<T>::other type;
+#endif
 };
 
 } // namespace inject
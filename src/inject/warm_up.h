@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2012 Itay Duvdevani
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __INJECT_WARM_UP_H__
+#define __INJECT_WARM_UP_H__
+
+#include "context.h"
+#include "executor.h"
+
+#ifdef INJECT_HAS_STD_THREADS
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace inject {
+
+template<int ID>
+void context<ID>::singleton_dependencies(unique_id component_id,
+        std::vector<unique_id>& found, std::vector<unique_id>& visited) {
+    component_descriptor* desc = registry().find(component_id);
+    if (desc == 0 || std::find(visited.begin(), visited.end(), component_id)
+            != visited.end()) {
+        return;
+    }
+
+    visited.push_back(component_id);
+
+    std::vector<unique_id> dependencies(desc->constructor_dependencies);
+    dependencies.insert(dependencies.end(),
+        desc->activator_dependencies.begin(),
+        desc->activator_dependencies.end());
+
+    for (std::size_t i = 0 ; i < dependencies.size() ; ++i) {
+        binding bind;
+        try {
+            bind = find_binding(dependencies[i]);
+        } catch (const std::exception&) {
+            // activating the dependent will report it
+            continue;
+        }
+
+        if (bind.scope() == scope_singleton) {
+            found.push_back(dependencies[i]);
+        } else {
+            // non-singletons are activated along with their dependent, which
+            // then depends on what they depend on
+            singleton_dependencies(bind.to(), found, visited);
+        }
+    }
+}
+
+template<int ID>
+void context<ID>::warm_up(unsigned threads) {
+    /**
+     * the activations, run on the shared executor. each job holds on to it,
+     * so it outlives the last one even if warm_up doesn't
+     */
+    struct activations : std::enable_shared_from_this<activations> {
+        context<ID>* ctx;
+
+        /**
+         * the singleton bindings, the singletons waiting for each, and the
+         * number of singletons each is waiting for
+         */
+        std::vector<binding> singletons;
+        std::vector< std::vector<std::size_t> > dependents;
+        std::vector<std::size_t> pending;
+
+        std::mutex lock;
+        std::condition_variable changed;
+        std::deque<std::size_t> ready;
+        std::size_t running;
+        std::size_t limit;
+        std::exception_ptr failure;
+
+        /** submits ready activations, up to the limit. call with the lock */
+        void dispatch() {
+            while (!failure && !ready.empty() && running < limit) {
+                std::shared_ptr<activations> self = this->shared_from_this();
+                std::size_t i = ready.front();
+                try {
+                    executor::shared().submit<void>([self, i] {
+                        self->activate(i);
+                    });
+                } catch (...) {
+                    failure = std::current_exception();
+                    return;
+                }
+                ready.pop_front();
+                ++running;
+            }
+        }
+
+        void activate(std::size_t i) {
+            std::exception_ptr failed;
+            try {
+                ctx->instance(singletons[i].what());
+            } catch (...) {
+                failed = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> guard(lock);
+            --running;
+            if (failed) {
+                if (!failure) {
+                    failure = failed;
+                }
+            } else {
+                for (std::size_t j = 0 ; j < dependents[i].size() ; ++j) {
+                    if (--pending[dependents[i][j]] == 0) {
+                        ready.push_back(dependents[i][j]);
+                    }
+                }
+                dispatch();
+            }
+            changed.notify_all();
+        }
+    };
+
+    std::shared_ptr<activations> run = std::make_shared<activations>();
+    run->ctx = this;
+
+    std::vector<binding>& singletons = run->singletons;
+    std::vector< std::vector<std::size_t> >& dependents = run->dependents;
+    std::vector<std::size_t>& pending = run->pending;
+
+    {
+        scoped_lock lock(_lock);
+
+        std::vector<binding> bound;
+        effective_bindings().copy_to(bound);
+
+        // components bound by default, unless bound otherwise
+        for (unique_id id = 0 ; id < registry().end() ; ++id) {
+            component_descriptor* desc = registry().find(id);
+            if (desc != 0 && desc->default_binding.what() == id &&
+                    effective_bindings().find(id) == 0) {
+                bound.push_back(desc->default_binding);
+            }
+        }
+
+        id_map<std::size_t> node_of;
+        for (std::size_t i = 0 ; i < bound.size() ; ++i) {
+            if (bound[i].scope() == scope_singleton) {
+                node_of[bound[i].what()] = singletons.size();
+                singletons.push_back(bound[i]);
+            }
+        }
+
+        dependents.resize(singletons.size());
+        pending.resize(singletons.size());
+
+        for (std::size_t i = 0 ; i < singletons.size() ; ++i) {
+            std::vector<unique_id> found;
+            std::vector<unique_id> visited;
+            singleton_dependencies(singletons[i].to(), found, visited);
+
+            std::sort(found.begin(), found.end());
+            found.erase(std::unique(found.begin(), found.end()), found.end());
+
+            for (std::size_t j = 0 ; j < found.size() ; ++j) {
+                const std::size_t* node = node_of.find(found[j]);
+                if (node != 0 && *node != i) {
+                    dependents[*node].push_back(i);
+                    ++pending[i];
+                }
+            }
+        }
+    }
+
+    // singletons on (or after) a dependency cycle can't be ordered - they're
+    // activated one by one afterwards, which reports the cycle
+    std::vector<std::size_t> unordered;
+    {
+        std::vector<std::size_t> left(pending);
+        std::vector<std::size_t> ready;
+        for (std::size_t i = 0 ; i < left.size() ; ++i) {
+            if (left[i] == 0) {
+                ready.push_back(i);
+            }
+        }
+
+        while (!ready.empty()) {
+            std::size_t i = ready.back();
+            ready.pop_back();
+            for (std::size_t j = 0 ; j < dependents[i].size() ; ++j) {
+                if (--left[dependents[i][j]] == 0) {
+                    ready.push_back(dependents[i][j]);
+                }
+            }
+        }
+
+        for (std::size_t i = 0 ; i < left.size() ; ++i) {
+            if (left[i] != 0) {
+                unordered.push_back(i);
+                pending[i] = 0;
+            }
+        }
+    }
+
+    run->running = 0;
+    run->limit = std::max(threads, 1u);
+
+    for (std::size_t i = 0 ; i < pending.size() ; ++i) {
+        if (pending[i] == 0 && std::find(unordered.begin(), unordered.end(), i)
+                == unordered.end()) {
+            run->ready.push_back(i);
+        }
+    }
+
+    // activations already running are waited for, even once one failed
+    std::exception_ptr failure;
+    {
+        std::unique_lock<std::mutex> guard(run->lock);
+        run->dispatch();
+        run->changed.wait(guard, [&run] {
+            return run->running == 0 &&
+                (run->ready.empty() || run->failure);
+        });
+        failure = run->failure;
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    for (std::size_t i = 0 ; i < unordered.size() ; ++i) {
+        instance(singletons[unordered[i]].what());
+    }
+}
+
+} // namespace inject
+
+#endif // INJECT_HAS_STD_THREADS
+
+#endif // __INJECT_WARM_UP_H__
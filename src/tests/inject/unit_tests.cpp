@@ -24,11 +24,44 @@
 #define BOOST_TEST_DYN_LINK
 
 #include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <iterator>
+#include <algorithm>
 
 #include <boost/test/unit_test.hpp>
+#include <boost/weak_ptr.hpp>
 
 #include "inject/inject.h"
 
+#ifdef INJECT_HAS_STD_THREADS
+#include <thread>
+#include <chrono>
+#endif
+
+// a single-threaded reference count, counting increments
+class counting_count : public inject::unsynchronized_count {
+public:
+    static int increments;
+
+    explicit counting_count(long count) : inject::unsynchronized_count(count) { }
+
+    void increment() {
+        increments++;
+        inject::unsynchronized_count::increment();
+    }
+};
+
+int counting_count::increments = 0;
+
+// context 2 hands out intrusive pointers
+namespace inject {
+template<>
+struct context_traits<2> {
+    typedef intrusive_ptr_policy<counting_count> pointer_policy;
+};
+}
+
 using namespace boost;
 using namespace inject;
 using namespace std;
@@ -147,12 +180,21 @@ BOOST_AUTO_TEST_CASE(inject_without_component)
     }
 }
 
+class unprovided_impl {
+public:
+    static int constructed;
+    unprovided_impl() { ++constructed; }
+};
+
+int unprovided_impl::constructed = 0;
+
 BOOST_AUTO_TEST_CASE(inject_bound_without_providing)
 {
     context<>::component<service> x;
     context<>::component<impl1> xx;
     // impl1 does not provide service, but bound as implementation
     context<>::component<service>::implemented_by<impl1> xxx;
+    context<>::component<unprovided_impl> y;
     
     context<> c;
     c.bind<service, impl1>();
@@ -164,6 +206,15 @@ BOOST_AUTO_TEST_CASE(inject_bound_without_providing)
         BOOST_CHECK_EQUAL(e.bound(), id_of<impl1>::id());
         BOOST_CHECK_EQUAL(e.interface(), id_of<service>::id());
     }
+
+    // the mistake is found before anything is constructed, in every scope
+    c.bind<service, unprovided_impl>();
+    BOOST_CHECK_THROW(c.instance<service>(), not_providing);
+    c.bind<service, unprovided_impl, scope_singleton>();
+    BOOST_CHECK_THROW(c.instance<service>(), not_providing);
+    c.bind<service, unprovided_impl, scope_pooled>();
+    BOOST_CHECK_THROW(c.instance<service>(), not_providing);
+    BOOST_CHECK_EQUAL(0, unprovided_impl::constructed);
 }
 
 BOOST_AUTO_TEST_CASE(context_nesting_override_binding)
@@ -211,6 +262,38 @@ BOOST_AUTO_TEST_CASE(context_nesting_inherit_binding)
     BOOST_CHECK_EQUAL(p2->id(), id_of<impl1>::id());
 }
 
+BOOST_AUTO_TEST_CASE(context_deep_nesting)
+{
+    context<>::component<service> x;
+    context<>::component<impl1> xx;
+    context<>::component<impl1>::provides<service> xxx;
+    context<>::component<impl2> y;
+    context<>::component<impl2>::provides<service> yy;
+    context<>::component<impl2>::provides<impl2> yyy;
+
+    context<> c1;
+    c1.bind<service, impl1>();
+    c1.bind<impl2>();
+
+    context<> c2;
+    context<> c3;
+    c3.bind<service, impl2>();
+    context<> c4;
+    context<> c5;
+
+    // overridden in c3, inherited from c1
+    BOOST_CHECK_EQUAL(c5.instance<service>()->id(), id_of<impl2>::id());
+    BOOST_CHECK_EQUAL(c5.instance<impl2>()->id(), id_of<impl2>::id());
+    BOOST_CHECK_EQUAL(c2.instance<service>()->id(), id_of<impl1>::id());
+
+    // rebinding a parent is visible to nested contexts not overriding it
+    c3.bind<service, impl1>();
+    BOOST_CHECK_EQUAL(c5.instance<service>()->id(), id_of<impl1>::id());
+    c1.bind<service, impl2>();
+    BOOST_CHECK_EQUAL(c2.instance<service>()->id(), id_of<impl2>::id());
+    BOOST_CHECK_EQUAL(c5.instance<service>()->id(), id_of<impl1>::id());
+}
+
 BOOST_AUTO_TEST_CASE(rebind)
 {
     context<>::component<service> x;
@@ -229,6 +312,53 @@ BOOST_AUTO_TEST_CASE(rebind)
     BOOST_CHECK_EQUAL(p2->id(), id_of<impl2>::id());
 }
 
+BOOST_AUTO_TEST_CASE(rebind_singleton)
+{
+    context<>::component<service> x;
+    context<>::component<impl1> xx;
+    context<>::component<impl1>::provides<service> xxx;
+    context<>::component<impl2> y;
+    context<>::component<impl2>::provides<service> yy;
+
+    context<> c;
+    c.bind<service, impl1, scope_singleton>();
+    context<>::injected<service> p;
+    context<>::injected<service> p2;
+    BOOST_CHECK(p.get() == p2.get());
+    
+    c.bind<service, impl2, scope_singleton>();
+    context<>::injected<service> p3;
+    BOOST_CHECK_EQUAL(p3->id(), id_of<impl2>::id());
+    
+    c.bind<service, impl1, scope_singleton>();
+    context<>::injected<service> p4;
+    BOOST_CHECK(p.get() == p4.get());
+}
+
+BOOST_AUTO_TEST_CASE(rebind_parent)
+{
+    context<>::component<service> x;
+    context<>::component<impl1> xx;
+    context<>::component<impl1>::provides<service> xxx;
+    context<>::component<impl2> y;
+    context<>::component<impl2>::provides<service> yy;
+
+    context<> parent;
+    parent.bind<service, impl1, scope_singleton>();
+    context<> child;
+
+    context<>::ptr<service>::type first = child.instance<service>();
+    BOOST_CHECK_EQUAL(first->id(), id_of<impl1>::id());
+
+    // unrelated bindings keep the singleton
+    child.bind<impl2, impl2>();
+    BOOST_CHECK(child.instance<service>() == first);
+
+    // rebinding the parent reaches the child
+    parent.bind<service, impl2>();
+    BOOST_CHECK_EQUAL(child.instance<service>()->id(), id_of<impl2>::id());
+}
+
 BOOST_AUTO_TEST_CASE(bind_by_name)
 {
     context<>::component<service> x("s");
@@ -319,24 +449,39 @@ BOOST_AUTO_TEST_CASE(default_impl_override)
     BOOST_CHECK_EQUAL(actual->id(), id_of<impl2>::id());
 }
 
-template<class T>
-struct TestAlloc {
-
+// counters are kept per Tag, so they're shared by all rebound allocators
+template<class Tag>
+struct TestAllocCounters {
     static int allocate_times;
     static int deallocate_times;
+};
+
+template<class Tag> int TestAllocCounters<Tag>::allocate_times = 0;
+template<class Tag> int TestAllocCounters<Tag>::deallocate_times = 0;
+
+template<class T, class Tag = T>
+struct TestAlloc : TestAllocCounters<Tag> {
+
+    typedef T value_type;
+
+    using TestAllocCounters<Tag>::allocate_times;
+    using TestAllocCounters<Tag>::deallocate_times;
 
     template<class U>
     struct rebind {
-        typedef TestAlloc<U> other;
+        typedef TestAlloc<U, Tag> other;
     };
 
     TestAlloc() throw() {}
-    TestAlloc(const TestAlloc<T>&) throw() {}
-    template<class U> TestAlloc(const TestAlloc<U>&) throw() {}
+    TestAlloc(const TestAlloc<T, Tag>&) throw() {}
+    template<class U> TestAlloc(const TestAlloc<U, Tag>&) throw() {}
+
+    bool operator==(const TestAlloc<T, Tag>&) const { return true; }
+    bool operator!=(const TestAlloc<T, Tag>&) const { return false; }
 
     T* allocate(size_t n, const T* hint=0) {
         allocate_times++;
-        return (T*)operator new(sizeof(T));
+        return (T*)operator new(sizeof(T) * n);
     }
 
     void deallocate(T* p, size_t n) {
@@ -353,8 +498,6 @@ struct TestAlloc {
     }
 };
 
-template<class T> int TestAlloc<T>::allocate_times = 0;
-template<class T> int TestAlloc<T>::deallocate_times = 0;
 
 BOOST_AUTO_TEST_CASE(custom_allocator_simple_inject)
 {
@@ -382,6 +525,195 @@ BOOST_AUTO_TEST_CASE(custom_allocator_simple_inject)
     BOOST_CHECK_EQUAL(1, TestAlloc<impl1>::deallocate_times);
 }
 
+class counted_impl : public service {
+public:
+    static int destroyed;
+
+    ~counted_impl() { destroyed++; }
+
+    unique_id id() {
+        return id_of<counted_impl>::id();
+    }
+};
+
+int counted_impl::destroyed = 0;
+
+BOOST_AUTO_TEST_CASE(test_instantiate_n)
+{
+    context<>::component<service> x;
+    context<>::component<counted_impl> xx;
+    context<>::component<counted_impl>::allocator< TestAlloc<counted_impl> > xxx;
+    context<>::component<counted_impl>::provides<service> xxxx;
+
+    context<> c;
+    c.bind<service, counted_impl>();
+
+    std::vector<context<>::ptr<service>::type> instances;
+    c.instantiate_n<service>(100, std::back_inserter(instances));
+
+    BOOST_REQUIRE_EQUAL(instances.size(), 100u);
+    BOOST_CHECK_EQUAL(instances.front()->id(), id_of<counted_impl>::id());
+    BOOST_CHECK(instances.front().get() != instances.back().get());
+
+    // a single allocation for all instances
+    BOOST_CHECK_EQUAL(1, TestAlloc<counted_impl>::allocate_times);
+
+    // each instance is destroyed on its own, memory is given back with the
+    // last one
+    instances.resize(1);
+    BOOST_CHECK_EQUAL(99, counted_impl::destroyed);
+    BOOST_CHECK_EQUAL(0, TestAlloc<counted_impl>::deallocate_times);
+
+    // the reference counts live in the block too - a weak pointer keeps it
+    boost::weak_ptr<service> weak = instances.front();
+    instances.clear();
+    BOOST_CHECK_EQUAL(100, counted_impl::destroyed);
+    BOOST_CHECK_EQUAL(0, TestAlloc<counted_impl>::deallocate_times);
+
+    weak.reset();
+    BOOST_CHECK_EQUAL(1, TestAlloc<counted_impl>::allocate_times);
+    BOOST_CHECK_EQUAL(1, TestAlloc<counted_impl>::deallocate_times);
+}
+
+class pooled_impl : public service {
+public:
+    static int constructed;
+    static int reset_times;
+    static int destroyed;
+
+    pooled_impl() { constructed++; }
+    ~pooled_impl() { destroyed++; }
+
+    void reset() { reset_times++; }
+
+    unique_id id() {
+        return id_of<pooled_impl>::id();
+    }
+};
+
+int pooled_impl::constructed = 0;
+int pooled_impl::reset_times = 0;
+int pooled_impl::destroyed = 0;
+
+BOOST_AUTO_TEST_CASE(test_scope_pooled)
+{
+    context<>::component<service> x;
+    context<>::component<pooled_impl> xx;
+    context<>::component<pooled_impl>::provides<service> xxx;
+    context<>::component<pooled_impl>::pooled<1> xxxx;
+    context<>::component<pooled_impl>::recycled_by<&pooled_impl::reset> xxxxx;
+
+    context<>::ptr<service>::type outliving;
+
+    {
+        context<> c;
+        c.bind<service, pooled_impl, scope_pooled>();
+
+        service* first = c.instance<service>().get();
+        BOOST_CHECK_EQUAL(first->id(), id_of<pooled_impl>::id());
+
+        // released instance is reset and reused
+        BOOST_CHECK(c.instance<service>().get() == first);
+        BOOST_CHECK_EQUAL(1, pooled_impl::constructed);
+        BOOST_CHECK_EQUAL(2, pooled_impl::reset_times);
+        BOOST_CHECK_EQUAL(0, pooled_impl::destroyed);
+
+        // no idle instance - a new one is created, but only one is kept
+        {
+            context<>::ptr<service>::type a = c.instance<service>();
+            context<>::ptr<service>::type b = c.instance<service>();
+            BOOST_CHECK(a.get() != b.get());
+            BOOST_CHECK_EQUAL(2, pooled_impl::constructed);
+        }
+        BOOST_CHECK_EQUAL(1, pooled_impl::destroyed);
+
+        outliving = c.instance<service>();
+    }
+
+    // the pool goes away with the last lent instance
+    BOOST_CHECK_EQUAL(1, pooled_impl::destroyed);
+    outliving.reset();
+    BOOST_CHECK_EQUAL(2, pooled_impl::destroyed);
+}
+
+class arena_impl : public service {
+public:
+    static std::vector<arena_impl*> destroyed;
+
+    ~arena_impl() { destroyed.push_back(this); }
+
+    unique_id id() {
+        return id_of<arena_impl>::id();
+    }
+};
+
+std::vector<arena_impl*> arena_impl::destroyed;
+
+BOOST_AUTO_TEST_CASE(test_arena_context)
+{
+    context<>::component<service> x;
+    context<>::component<arena_impl> xx;
+    context<>::component<arena_impl>::allocator< TestAlloc<arena_impl> > xxx;
+    context<>::component<arena_impl>::provides<service> xxxx;
+
+    context<> parent;
+    parent.bind<service, arena_impl>();
+
+    std::vector<arena_impl*> created;
+
+    {
+        context<> c(arena);
+
+        for (int i = 0 ; i < 100 ; ++i) {
+            context<>::ptr<service>::type p = c.instance<service>();
+            BOOST_CHECK_EQUAL(p->id(), id_of<arena_impl>::id());
+            created.push_back(static_cast<arena_impl*>(p.get()));
+        }
+
+        // released pointers don't destroy anything
+        BOOST_CHECK(arena_impl::destroyed.empty());
+    }
+
+    // destroyed with the context, in reverse order, without the allocator
+    BOOST_REQUIRE_EQUAL(arena_impl::destroyed.size(), 100u);
+    BOOST_CHECK(std::equal(created.rbegin(), created.rend(),
+        arena_impl::destroyed.begin()));
+    BOOST_CHECK_EQUAL(0, TestAlloc<arena_impl>::allocate_times);
+    BOOST_CHECK_EQUAL(0, TestAlloc<arena_impl>::deallocate_times);
+}
+
+class throwing_impl : public service {
+public:
+    static int destroyed;
+
+    throwing_impl() { throw std::runtime_error("can't construct"); }
+    ~throwing_impl() { destroyed++; }
+
+    unique_id id() {
+        return id_of<throwing_impl>::id();
+    }
+};
+
+int throwing_impl::destroyed = 0;
+
+BOOST_AUTO_TEST_CASE(custom_allocator_constructor_throws)
+{
+    context<>::component<service> x;
+    context<>::component<throwing_impl> xx;
+    context<>::component<throwing_impl>::allocator< TestAlloc<throwing_impl> > xxx;
+    context<>::component<throwing_impl>::provides<service> xxxx;
+
+    context<> c;
+    c.bind<service, throwing_impl>();
+
+    BOOST_CHECK_THROW(context<>::injected<service> p, std::runtime_error);
+
+    // memory is given back, but an instance never constructed isn't destroyed
+    BOOST_CHECK_EQUAL(1, TestAlloc<throwing_impl>::allocate_times);
+    BOOST_CHECK_EQUAL(1, TestAlloc<throwing_impl>::deallocate_times);
+    BOOST_CHECK_EQUAL(0, throwing_impl::destroyed);
+}
+
 BOOST_AUTO_TEST_CASE(bind_to_self)
 {
     context<>::component<impl1> b1;
@@ -440,6 +772,7 @@ BOOST_AUTO_TEST_CASE(test_circular_dependency)
     context<>::component<cdep2_ok> d3;
     context<>::component<cdep2> d4;
     context<>::component<cdep2>::provides<cdep2_ok> d5;
+    context<>::component<cdep2>::provides<cdep2> d6;
 
     context<> c;
     c.bind<cdep1>();
@@ -569,6 +902,902 @@ BOOST_AUTO_TEST_CASE(test_component_multiple_inheritance)
     BOOST_CHECK_EQUAL(actual_b->b(), 20);
 }
 
+BOOST_AUTO_TEST_CASE(test_singleton_multiple_interfaces)
+{
+    context<>::component<service_a> y;
+    context<>::component<service_b> yy;
+
+    context<>::component<ab_impl> yyy;
+    context<>::component<ab_impl>::provides<service_a> yyyy;
+    context<>::component<ab_impl>::provides<service_b> yyyyy;
+
+    context<> c;
+
+    c.bind<service_a, ab_impl, scope_singleton>();
+    c.bind<service_b, ab_impl, scope_singleton>();
+
+    context<>::injected<service_a> actual_a;
+    context<>::injected<service_b> actual_b;
+
+    BOOST_CHECK(static_cast<ab_impl*>(actual_a.get()) ==
+        static_cast<ab_impl*>(actual_b.get()));
+}
+
+class intrusive_impl : public service_a, public service_b {
+public:
+    static int destroyed;
+
+    virtual ~intrusive_impl() { destroyed++; }
+
+    virtual int a() const { return 10; }
+    virtual int b() const { return 20; }
+};
+
+int intrusive_impl::destroyed = 0;
+
+class intrusive_consumer {
+public:
+    context<2>::ptr<service_b>::type b;
+
+    intrusive_consumer() { }
+    intrusive_consumer(context<2>::ptr<service_b>::type b) : b(b) { }
+};
+
+struct plain_first { int first; };
+struct plain_second { int second; };
+
+class intrusive_plain : public plain_first, public plain_second {
+public:
+    static int destroyed;
+
+    intrusive_plain() { first = 1; second = 2; }
+    ~intrusive_plain() { destroyed++; }
+};
+
+int intrusive_plain::destroyed = 0;
+
+BOOST_AUTO_TEST_CASE(test_intrusive_ptr_policy)
+{
+    context<2>::component<service_a> y;
+    context<2>::component<service_b> yy;
+
+    context<2>::component<intrusive_impl> yyy;
+    context<2>::component<intrusive_impl>::provides<service_a> yyyy;
+    context<2>::component<intrusive_impl>::provides<service_b> yyyyy;
+
+    context<2>::component<intrusive_consumer> z;
+    context<2>::component<intrusive_consumer>::provides<intrusive_consumer> zz;
+    context<2>::component<intrusive_consumer>::constructor<service_b> zzz;
+
+    BOOST_CHECK_EQUAL(sizeof(context<2>::ptr<service_b>::type),
+        2 * sizeof(void*));
+
+    context<2> c;
+    c.bind<service_a, intrusive_impl, scope_singleton>();
+    c.bind<service_b, intrusive_impl>();
+    c.bind<intrusive_consumer>();
+
+    {
+        // service_b is at an offset within the instance
+        context<2>::injected<intrusive_consumer> consumer;
+        BOOST_CHECK_EQUAL(consumer->b->b(), 20);
+
+        context<2>::ptr<service_b>::type copy = consumer->b;
+        consumer->b.reset();
+        BOOST_CHECK_EQUAL(0, intrusive_impl::destroyed);
+        BOOST_CHECK_EQUAL(copy->b(), 20);
+    }
+    BOOST_CHECK_EQUAL(1, intrusive_impl::destroyed);
+
+    // the singleton is kept by the context
+    BOOST_CHECK(c.instance<service_a>() == c.instance<service_a>());
+    BOOST_CHECK_EQUAL(1, intrusive_impl::destroyed);
+
+    // a non-polymorphic interface at an offset finds its header too
+    context<2>::component<plain_second> w;
+    context<2>::component<intrusive_plain> ww;
+    context<2>::component<intrusive_plain>::provides<plain_second> www;
+    c.bind<plain_second, intrusive_plain>();
+    {
+        context<2>::ptr<plain_second>::type second =
+            c.instance<plain_second>();
+        BOOST_CHECK_EQUAL(2, second->second);
+    }
+    BOOST_CHECK_EQUAL(1, intrusive_plain::destroyed);
+}
+
+#ifdef INJECT_HAS_RVALUE_REFERENCES
+BOOST_AUTO_TEST_CASE(test_resolve_moves_pointers)
+{
+    context<2>::component<service_a> y;
+    context<2>::component<service_b> yy;
+
+    context<2>::component<intrusive_impl> yyy;
+    context<2>::component<intrusive_impl>::provides<service_a> yyyy;
+    context<2>::component<intrusive_impl>::provides<service_b> yyyyy;
+
+    context<2> c;
+    c.bind<service_a, intrusive_impl, scope_singleton>();
+    c.bind<service_b, intrusive_impl>();
+
+    // a new instance is handed over without touching its count
+    counting_count::increments = 0;
+    context<2>::injected<service_b> b;
+    BOOST_CHECK_EQUAL(b->b(), 20);
+    BOOST_CHECK_EQUAL(0, counting_count::increments);
+
+    // a singleton is shared with the context - once created, a single
+    // reference is added
+    context<2>::injected<service_a> first;
+    counting_count::increments = 0;
+    context<2>::injected<service_a> second;
+    BOOST_CHECK(first.get() == second.get());
+    BOOST_CHECK_EQUAL(1, counting_count::increments);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(test_singleton_ref)
+{
+    context<2>::component<service_a> y;
+    context<2>::component<service_b> yy;
+
+    context<2>::component<intrusive_impl> yyy;
+    context<2>::component<intrusive_impl>::provides<service_a> yyyy;
+    context<2>::component<intrusive_impl>::provides<service_b> yyyyy;
+
+    context<2> c;
+    c.bind<service_a, intrusive_impl, scope_singleton>();
+    c.bind<service_b, intrusive_impl>();
+
+    // borrowing creates the singleton on first use
+    context<2>::singleton_ref<service_a> first;
+    BOOST_CHECK_EQUAL(first->a(), 10);
+    BOOST_CHECK(first.get() == c.instance<service_a>().get());
+
+    // later borrows and copies never touch the count
+    counting_count::increments = 0;
+    context<2>::singleton_ref<service_a> second(c);
+    context<2>::singleton_ref<service_a> copy = second;
+    BOOST_CHECK(&*copy == &c.singleton<service_a>());
+    BOOST_CHECK(first.get() == copy.get());
+    BOOST_CHECK_EQUAL(0, counting_count::increments);
+
+    BOOST_CHECK_THROW(c.singleton<service_b>(), not_singleton);
+}
+
+#ifdef INJECT_HAS_STD_THREADS
+class slow_singleton {
+public:
+    static std::atomic<int> constructed;
+
+    slow_singleton() {
+        ++constructed;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+};
+
+std::atomic<int> slow_singleton::constructed(0);
+
+class other_slow_singleton : public slow_singleton { };
+
+BOOST_AUTO_TEST_CASE(test_concurrent_singletons)
+{
+    context<>::component<slow_singleton> x;
+    context<>::component<slow_singleton>::provides<slow_singleton> xx;
+    context<>::component<other_slow_singleton> y;
+    context<>::component<other_slow_singleton>::provides<other_slow_singleton> yy;
+
+    context<> c;
+    c.bind<slow_singleton, slow_singleton, scope_singleton>();
+    c.bind<other_slow_singleton, other_slow_singleton, scope_singleton>();
+
+    slow_singleton::constructed = 0;
+
+    const int threads = 8;
+    slow_singleton* first[threads];
+    other_slow_singleton* second[threads];
+
+    std::vector<std::thread> workers;
+    for (int i = 0 ; i < threads ; ++i) {
+        workers.push_back(std::thread([&c, &first, &second, i] {
+            first[i] = c.instance<slow_singleton>().get();
+            second[i] = c.instance<other_slow_singleton>().get();
+        }));
+    }
+
+    for (int i = 0 ; i < threads ; ++i) {
+        workers[i].join();
+    }
+
+    // each singleton was activated once, and every thread got it
+    BOOST_CHECK_EQUAL(2, slow_singleton::constructed.load());
+    for (int i = 0 ; i < threads ; ++i) {
+        BOOST_CHECK(first[i] == first[0]);
+        BOOST_CHECK(second[i] == second[0]);
+    }
+}
+
+template<int N>
+struct registered_late { };
+
+template<int N>
+struct register_late {
+    static void declare() {
+        context<>::component< registered_late<N> > x;
+        register_late<N - 1>::declare();
+    }
+};
+
+template<>
+struct register_late<0> {
+    static void declare() { }
+};
+
+BOOST_AUTO_TEST_CASE(test_register_while_resolving)
+{
+    context<>::component<service> x;
+    context<>::component<impl1> xx;
+    context<>::component<impl1>::provides<service> xxx;
+
+    context<> c;
+    c.bind<service, impl1>();
+
+    // components registered meanwhile grow the registry under the activation
+    std::atomic<bool> done(false);
+    std::atomic<bool> consistent(true);
+    std::thread resolver([&c, &done, &consistent] {
+        while (!done) {
+            if (c.instance<service>()->id() != id_of<impl1>::id()) {
+                consistent = false;
+            }
+        }
+    });
+
+    register_late<100>::declare();
+
+    done = true;
+    resolver.join();
+    BOOST_CHECK(consistent);
+}
+
+class shared_pooled : public service {
+public:
+    static std::atomic<int> constructed;
+    static std::atomic<int> destroyed;
+
+    /** whether a thread has the instance */
+    std::atomic<bool> in_use;
+
+    shared_pooled() : in_use(false) { constructed++; }
+    ~shared_pooled() { destroyed++; }
+
+    unique_id id() {
+        return id_of<shared_pooled>::id();
+    }
+};
+
+std::atomic<int> shared_pooled::constructed(0);
+std::atomic<int> shared_pooled::destroyed(0);
+
+BOOST_AUTO_TEST_CASE(test_concurrent_pooling)
+{
+    context<>::component<service> x;
+    context<>::component<shared_pooled> xx;
+    context<>::component<shared_pooled>::provides<service> xxx;
+    context<>::component<shared_pooled>::pooled<4> xxxx;
+
+    {
+        context<> c;
+        c.bind<service, shared_pooled, scope_pooled>();
+
+        // an idle instance is lent to a single thread at a time
+        std::atomic<bool> exclusive(true);
+        std::vector<std::thread> workers;
+        for (int i = 0 ; i < 8 ; ++i) {
+            workers.push_back(std::thread([&c, &exclusive] {
+                for (int j = 0 ; j < 1000 ; ++j) {
+                    context<>::ptr<service>::type s = c.instance<service>();
+                    shared_pooled* p = static_cast<shared_pooled*>(s.get());
+                    if (p->in_use.exchange(true)) {
+                        exclusive = false;
+                    }
+                    p->in_use = false;
+                }
+            }));
+        }
+
+        for (std::size_t i = 0 ; i < workers.size() ; ++i) {
+            workers[i].join();
+        }
+        BOOST_CHECK(exclusive);
+    }
+
+    BOOST_CHECK_EQUAL(shared_pooled::constructed.load(),
+        shared_pooled::destroyed.load());
+}
+
+BOOST_AUTO_TEST_CASE(test_per_thread_context_stack)
+{
+    context<>::component<service> x;
+    context<>::component<impl1> xx;
+    context<>::component<impl1>::provides<service> xxx;
+    context<>::component<impl2> y;
+    context<>::component<impl2>::provides<service> yy;
+
+    context<> c;
+    c.bind<service, impl1>();
+
+    // a thread with no contexts of its own resolves from the global context,
+    // whatever the other threads' current contexts are
+    context<>* seen = 0;
+    std::thread([&seen] { seen = &context<>::get_current(); }).join();
+    BOOST_CHECK(seen != &c);
+    BOOST_CHECK(&context<>::get_current() == &c);
+
+    // each thread injects from the top of its own stack
+    const int threads = 2;
+    bool consistent[threads];
+
+    std::vector<std::thread> workers;
+    for (int i = 0 ; i < threads ; ++i) {
+        workers.push_back(std::thread([&consistent, i] {
+            context<> own;
+            unique_id expected;
+            if (i == 0) {
+                own.bind<service, impl1>();
+                expected = id_of<impl1>::id();
+            } else {
+                own.bind<service, impl2>();
+                expected = id_of<impl2>::id();
+            }
+
+            consistent[i] = true;
+            for (int j = 0 ; j < 1000 ; ++j) {
+                context<>::injected<service> s;
+                consistent[i] = consistent[i] && s->id() == expected;
+            }
+        }));
+    }
+
+    for (int i = 0 ; i < threads ; ++i) {
+        workers[i].join();
+        BOOST_CHECK(consistent[i]);
+    }
+
+    BOOST_CHECK(&context<>::get_current() == &c);
+}
+
+BOOST_AUTO_TEST_CASE(test_rebind_while_resolving)
+{
+    context<>::component<service> x;
+    context<>::component<impl1> xx;
+    context<>::component<impl1>::provides<service> xxx;
+    context<>::component<impl2> y;
+    context<>::component<impl2>::provides<service> yy;
+
+    context<> c;
+    c.bind<service, impl1, scope_singleton>();
+
+    std::atomic<bool> done(false);
+    std::atomic<bool> consistent(true);
+
+    std::vector<std::thread> readers;
+    for (int i = 0 ; i < 4 ; ++i) {
+        readers.push_back(std::thread([&c, &done, &consistent] {
+            while (!done) {
+                unique_id id = c.instance<service>()->id();
+                if (id != id_of<impl1>::id() && id != id_of<impl2>::id()) {
+                    consistent = false;
+                }
+            }
+        }));
+    }
+
+    // every rebinding publishes new plans, while the old ones are being read
+    for (int i = 0 ; i < 200 ; ++i) {
+        if (i % 2 == 0) {
+            c.bind<service, impl2, scope_singleton>();
+        } else {
+            c.bind<service, impl1, scope_singleton>();
+        }
+        std::this_thread::yield();
+    }
+
+    done = true;
+    for (std::size_t i = 0 ; i < readers.size() ; ++i) {
+        readers[i].join();
+    }
+
+    BOOST_CHECK(consistent);
+    BOOST_CHECK_EQUAL(c.instance<service>()->id(), id_of<impl1>::id());
+}
+
+class warm_base {
+public:
+    static std::atomic<int> activated;
+    int rank;
+
+    warm_base() : rank(++activated) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    virtual ~warm_base() { }
+};
+
+std::atomic<int> warm_base::activated(0);
+
+class warm_other : public warm_base { };
+
+// not a singleton - the singletons using it depend on warm_base through it
+class warm_helper {
+public:
+    context<>::ptr<warm_base>::type base;
+
+    warm_helper() { }
+    warm_helper(context<>::ptr<warm_base>::type b) : base(b) { }
+};
+
+class warm_top : public warm_base {
+public:
+    int helper_rank;
+    context<>::ptr<warm_other>::type other;
+
+    warm_top() : helper_rank(0) { }
+    warm_top(context<>::ptr<warm_helper>::type helper) :
+        helper_rank(helper->base->rank) { }
+
+    context<>::ptr<warm_other>::type& other_setter() { return other; }
+};
+
+BOOST_AUTO_TEST_CASE(test_warm_up)
+{
+    context<>::component<warm_base> x;
+    context<>::component<warm_base>::provides<warm_base> xx;
+    context<>::component<warm_other> y;
+    context<>::component<warm_other>::provides<warm_other> yy;
+    context<>::component<warm_helper> z;
+    context<>::component<warm_helper>::provides<warm_helper> zz;
+    context<>::component<warm_helper>::constructor<warm_base> zzz;
+    context<>::component<warm_top> w;
+    context<>::component<warm_top>::provides<warm_top> ww;
+    context<>::component<warm_top>::constructor<warm_helper> www;
+    context<>::component<warm_top>::assign_setter<warm_other,
+        &warm_top::other_setter> wwww;
+
+    context<> c;
+    c.bind<warm_base, warm_base, scope_singleton>();
+    c.bind<warm_other, warm_other, scope_singleton>();
+    c.bind<warm_helper>();
+    c.bind<warm_top, warm_top, scope_singleton>();
+
+    warm_base::activated = 0;
+    c.warm_up(4);
+    BOOST_CHECK_EQUAL(3, warm_base::activated.load());
+
+    // dependencies were activated first, and nothing is activated again
+    context<>::ptr<warm_top>::type top = c.instance<warm_top>();
+    BOOST_CHECK(top->rank > top->helper_rank);
+    BOOST_CHECK(top->rank > top->other->rank);
+    BOOST_CHECK(top->other == c.instance<warm_other>());
+    BOOST_CHECK_EQUAL(3, warm_base::activated.load());
+}
+
+class async_part {
+public:
+    static std::atomic<int> constructed;
+    std::thread::id thread;
+
+    async_part() : thread(std::this_thread::get_id()) {
+        ++constructed;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    virtual ~async_part() { }
+};
+
+std::atomic<int> async_part::constructed(0);
+
+class async_left : public async_part { };
+
+class async_failing : public async_part {
+public:
+    async_failing() { throw std::runtime_error("async_failing"); }
+};
+class async_right : public async_part { };
+
+class async_whole : public async_part {
+public:
+    context<>::ptr<async_left>::type left;
+    context<>::ptr<async_right>::type right;
+
+    async_whole() { }
+    async_whole(context<>::ptr<async_left>::type l,
+            context<>::ptr<async_right>::type r) :
+        left(l), right(r) { }
+};
+
+BOOST_AUTO_TEST_CASE(test_instance_async)
+{
+    context<>::component<async_left> x;
+    context<>::component<async_left>::provides<async_left> xx;
+    context<>::component<async_right> y;
+    context<>::component<async_right>::provides<async_right> yy;
+    context<>::component<async_whole> z;
+    context<>::component<async_whole>::provides<async_whole> zz;
+    context<>::component<async_whole>::constructor<async_left,
+        async_right> zzz;
+
+    context<> c;
+    c.bind<async_left>();
+    c.bind<async_right>();
+    c.bind<async_whole>();
+
+    async_part::constructed = 0;
+    std::future<context<>::ptr<async_whole>::type> pending =
+        c.instance_async<async_whole>();
+    context<>::ptr<async_whole>::type whole = pending.get();
+
+    // the arguments were resolved once, in the background
+    BOOST_CHECK_EQUAL(3, async_part::constructed.load());
+    BOOST_CHECK(whole->left && whole->right);
+    BOOST_CHECK(whole->thread != std::this_thread::get_id());
+    BOOST_CHECK(whole->left->thread != std::this_thread::get_id());
+    BOOST_CHECK(whole->right->thread != std::this_thread::get_id());
+}
+
+BOOST_AUTO_TEST_CASE(test_speculative_injection)
+{
+    context<>::component<async_left> x;
+    context<>::component<async_left>::provides<async_left> xx;
+    context<>::component<async_right> y;
+    context<>::component<async_right>::provides<async_right> yy;
+
+    context<> c;
+    c.bind<async_left>();
+
+    // construction starts right away, in the background
+    async_part::constructed = 0;
+    context<>::injected<async_left> s(speculative);
+    context<>::injected<async_left> copy(s);
+
+    BOOST_CHECK(s->thread != std::this_thread::get_id());
+    BOOST_CHECK(copy.get() == s.get());
+    BOOST_CHECK_EQUAL(1, async_part::constructed.load());
+
+    // a failed construction isn't kept - the next use asks the context again
+    context<>::injected<async_right> failing(speculative);
+    BOOST_CHECK_THROW(failing.get(), no_binding);
+    c.bind<async_right>();
+    BOOST_CHECK(failing.get() != 0);
+    BOOST_CHECK_EQUAL(2, async_part::constructed.load());
+
+    // dereferencing throws the failure too, instead of terminating
+    context<>::component<async_failing> z;
+    context<>::component<async_failing>::provides<async_failing> zz;
+    c.bind<async_failing>();
+    context<>::injected<async_failing> throwing(speculative);
+    BOOST_CHECK_THROW(throwing->thread, std::runtime_error);
+
+    // an arena isn't shared with the executor - the first use constructs it
+    context<> arena_context(arena);
+    int constructed = async_part::constructed.load();
+    context<>::injected<async_left> in_arena(speculative);
+    BOOST_CHECK_EQUAL(constructed, async_part::constructed.load());
+    BOOST_CHECK(in_arena->thread == std::this_thread::get_id());
+}
+
+class cross_b;
+
+/** started constructing on both threads */
+std::atomic<int> cross_started(0);
+
+/** waits (a while) for the other thread to start constructing too */
+class cross_base {
+public:
+    cross_base() {
+        ++cross_started;
+        for (int i = 0 ; i < 1000 && cross_started < 2 ; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+class cross_a : public cross_base {
+public:
+    context<>::injected<cross_b> b;
+};
+
+class cross_b : public cross_base {
+public:
+    context<>::injected<cross_a> a;
+};
+
+BOOST_AUTO_TEST_CASE(test_cross_thread_circular_dependency)
+{
+    context<>::component<cross_a> x;
+    context<>::component<cross_a>::provides<cross_a> xx;
+    context<>::component<cross_b> y;
+    context<>::component<cross_b>::provides<cross_b> yy;
+
+    context<> c;
+    c.bind<cross_a, cross_a, scope_singleton>();
+    c.bind<cross_b, cross_b, scope_singleton>();
+
+    // each thread activates one singleton, then waits for the other's -
+    // found out instead of waiting forever
+    cross_started = 0;
+    std::atomic<int> failed(0);
+    std::thread ta([&c, &failed] {
+        try {
+            c.instance<cross_a>();
+        } catch (const circular_dependency&) {
+            ++failed;
+        }
+    });
+    std::thread tb([&c, &failed] {
+        try {
+            c.instance<cross_b>();
+        } catch (const circular_dependency&) {
+            ++failed;
+        }
+    });
+
+    ta.join();
+    tb.join();
+    BOOST_CHECK_EQUAL(2, failed.load());
+}
+
+BOOST_AUTO_TEST_CASE(test_warm_up_field_cycle)
+{
+    context<>::component<cross_a> x;
+    context<>::component<cross_a>::provides<cross_a> xx;
+    context<>::component<cross_b> y;
+    context<>::component<cross_b>::provides<cross_b> yy;
+
+    context<> c;
+    c.bind<cross_a, cross_a, scope_singleton>();
+    c.bind<cross_b, cross_b, scope_singleton>();
+
+    // the injected<> fields aren't declared, so both are activated at once -
+    // and the cycle is reported instead of waited on forever
+    cross_started = 0;
+    BOOST_CHECK_THROW(c.warm_up(2), circular_dependency);
+}
+#endif
+
+#ifdef INJECT_HAS_COROUTINES
+// a minimal event loop - initializations suspend on it until it's run
+class io_loop {
+public:
+    struct next_turn {
+        io_loop& loop;
+
+        bool await_ready() { return false; }
+        void await_suspend(std::coroutine_handle<> waiting) {
+            std::lock_guard<std::mutex> guard(loop.lock);
+            loop.waiting.push_back(waiting);
+        }
+        void await_resume() { }
+    };
+
+    std::mutex lock;
+    std::vector< std::coroutine_handle<> > waiting;
+
+    next_turn turn() { return next_turn{*this}; }
+
+    bool idle() {
+        std::lock_guard<std::mutex> guard(lock);
+        return waiting.empty();
+    }
+
+    void run() {
+        for (;;) {
+            std::coroutine_handle<> next;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (waiting.empty()) {
+                    return;
+                }
+                next = waiting.front();
+                waiting.erase(waiting.begin());
+            }
+            next.resume();
+        }
+    }
+};
+
+io_loop the_io_loop;
+
+class io_part {
+public:
+    static int started;
+    bool ready;
+
+    io_part() : ready(false) { }
+    virtual ~io_part() { }
+
+    task<> load() {
+        ++started;
+        co_await the_io_loop.turn();
+        ready = true;
+    }
+};
+
+int io_part::started = 0;
+
+class io_left : public io_part {
+public:
+    task<> co_init() { return load(); }
+};
+
+class io_right : public io_part {
+public:
+    task<> co_init() { return load(); }
+};
+
+class io_whole : public io_part {
+public:
+    context<>::ptr<io_left>::type left;
+    context<>::ptr<io_right>::type right;
+
+    io_whole() { }
+    io_whole(context<>::ptr<io_left>::type l, context<>::ptr<io_right>::type r) :
+        left(l), right(r) { }
+
+    task<> co_init() { return load(); }
+};
+
+BOOST_AUTO_TEST_CASE(test_coroutine_initialization)
+{
+    context<>::component<io_left> x;
+    context<>::component<io_left>::provides<io_left> xx;
+    context<>::component<io_left>::initialized_by<&io_left::co_init> xxx;
+    context<>::component<io_right> y;
+    context<>::component<io_right>::provides<io_right> yy;
+    context<>::component<io_right>::initialized_by<&io_right::co_init> yyy;
+    context<>::component<io_whole> z;
+    context<>::component<io_whole>::provides<io_whole> zz;
+    context<>::component<io_whole>::constructor<io_left, io_right> zzz;
+    context<>::component<io_whole>::initialized_by<&io_whole::co_init> zzzz;
+
+    context<> c;
+    c.bind<io_left>();
+    c.bind<io_right>();
+    c.bind<io_whole>();
+
+    // both arguments are initializing at once, and the component waits for
+    // them before it's constructed
+    io_part::started = 0;
+    task<context<>::ptr<io_whole>::type> pending = c.co_instance<io_whole>();
+    BOOST_CHECK_EQUAL(2, io_part::started);
+    BOOST_CHECK(!pending.done());
+
+    the_io_loop.run();
+    BOOST_CHECK(pending.done());
+    context<>::ptr<io_whole>::type whole = pending.wait();
+    BOOST_CHECK_EQUAL(3, io_part::started);
+    BOOST_CHECK(whole->ready && whole->left->ready && whole->right->ready);
+
+    // other resolutions block until another thread completes initialization
+    std::thread loop_thread([] {
+        while (the_io_loop.idle()) {
+            std::this_thread::yield();
+        }
+        the_io_loop.run();
+    });
+    context<>::ptr<io_left>::type left = c.instance<io_left>();
+    loop_thread.join();
+    BOOST_CHECK(left->ready);
+}
+
+class co_cycle_b;
+
+class co_cycle_a {
+public:
+    co_cycle_a() { }
+    co_cycle_a(context<>::ptr<co_cycle_b>::type) { }
+};
+
+class co_cycle_b {
+public:
+    co_cycle_b() { }
+    co_cycle_b(context<>::ptr<co_cycle_a>::type) { }
+};
+
+class io_field_holder {
+public:
+    context<>::injected<io_left> left;
+};
+
+BOOST_AUTO_TEST_CASE(test_coroutine_resolution_errors)
+{
+    context<>::component<co_cycle_a> x;
+    context<>::component<co_cycle_a>::provides<co_cycle_a> xx;
+    context<>::component<co_cycle_a>::constructor<co_cycle_b> xxx;
+    context<>::component<co_cycle_b> y;
+    context<>::component<co_cycle_b>::provides<co_cycle_b> yy;
+    context<>::component<co_cycle_b>::constructor<co_cycle_a> yyy;
+    context<>::component<io_left> z;
+    context<>::component<io_left>::provides<io_left> zz;
+    context<>::component<io_left>::initialized_by<&io_left::co_init> zzz;
+    context<>::component<io_field_holder> w;
+    context<>::component<io_field_holder>::provides<io_field_holder> ww;
+
+    context<> c;
+    c.bind<co_cycle_a>();
+    c.bind<co_cycle_b>();
+    c.bind<io_left>();
+    c.bind<io_field_holder>();
+
+    // constructor arguments depending on themselves fail instead of recursing
+    task<context<>::ptr<co_cycle_a>::type> cycle = c.co_instance<co_cycle_a>();
+    BOOST_CHECK(cycle.done());
+    BOOST_CHECK_THROW(cycle.wait(), circular_dependency);
+
+    // a field's initialization would block the loop it's suspended on
+    io_part::started = 0;
+    task<context<>::ptr<io_field_holder>::type> holder =
+        c.co_instance<io_field_holder>();
+    BOOST_CHECK(holder.done());
+    BOOST_CHECK_THROW(holder.wait(), blocking_initialization);
+    BOOST_CHECK_EQUAL(0, io_part::started);
+    BOOST_CHECK(the_io_loop.idle());
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(test_batched_instances)
+{
+    context<>::component<service> x;
+    context<>::component<impl1> xx;
+    context<>::component<impl1>::provides<service> xxx;
+
+    context<>::component<service_a> y;
+    context<>::component<service_b> yy;
+
+    context<>::component<ab_impl> yyy;
+    context<>::component<ab_impl>::provides<service_a> yyyy;
+    context<>::component<ab_impl>::provides<service_b> yyyyy;
+
+    context<> c;
+    c.bind<service, impl1>();
+    c.bind<service_a, ab_impl, scope_singleton>();
+    c.bind<service_b, ab_impl, scope_singleton>();
+
+    context<>::instances_of<service, service_a, service_b>::type all =
+        c.instances<service, service_a, service_b>();
+
+    BOOST_CHECK_EQUAL(boost::get<0>(all)->id(), id_of<impl1>::id());
+    BOOST_CHECK_EQUAL(boost::get<1>(all)->a(), 10);
+    BOOST_CHECK_EQUAL(boost::get<2>(all)->b(), 20);
+    BOOST_CHECK(static_cast<ab_impl*>(boost::get<1>(all).get()) ==
+        static_cast<ab_impl*>(boost::get<2>(all).get()));
+}
+
+class ctor_inject_other {
+public:
+    context<1>::ptr<service>::type s;
+
+    ctor_inject_other() { }
+    ctor_inject_other(context<1>::ptr<service>::type s) : s(s) { }
+};
+
+BOOST_AUTO_TEST_CASE(test_ctor_inject_other_context)
+{
+    context<1>::component<service> x1;
+    context<1>::component<impl2> x2;
+    context<1>::component<impl2>::provides<service> x3;
+
+    context<1>::component<ctor_inject_other> x4;
+    context<1>::component<ctor_inject_other>::provides<ctor_inject_other> x5;
+    context<1>::component<ctor_inject_other>::constructor<service> x6;
+
+    context<1> c;
+    c.bind<service, impl2>();
+    c.bind<ctor_inject_other>();
+
+    // arguments are resolved from the context activating the component
+    BOOST_CHECK_EQUAL(c.instance<ctor_inject_other>()->s->id(),
+        id_of<impl2>::id());
+}
+
 class ctor_inject {
 private:
     int ctor_num;
@@ -977,4 +2206,90 @@ BOOST_AUTO_TEST_CASE(test_lazy_inject)
   BOOST_CHECK_EQUAL(lazy_snapshot->value, 0xdd);
 }
 
+struct dense_a {};
+struct dense_b {};
+
+BOOST_AUTO_TEST_CASE(test_dense_ids)
+{
+    unique_id a = id_of<dense_a>::id();
+    unique_id b = id_of<dense_b>::id();
+
+    BOOST_CHECK(a >= 0);
+    BOOST_CHECK_EQUAL(b, a + 1);
+    BOOST_CHECK_EQUAL(id_of<dense_a>::id(), a);
+}
+
+class static_consumer;
+
+typedef static_context<
+    static_binding<service, impl1>,
+    static_binding<impl2, impl2, scope_singleton>,
+    static_binding<static_consumer, static_consumer>
+> static_wiring;
+
+class static_consumer {
+public:
+    static_wiring::injected<service> s;
+    static_wiring::injected<impl2> lazy_s;
+
+    static_consumer() : lazy_s(lazy) { }
+};
+
+BOOST_AUTO_TEST_CASE(test_static_context)
+{
+    static_wiring::ptr<service>::type first = static_wiring::instance<service>();
+    static_wiring::ptr<service>::type second = static_wiring::instance<service>();
+
+    BOOST_CHECK_EQUAL(first->id(), id_of<impl1>::id());
+    BOOST_CHECK(first.get() != second.get());
+
+    BOOST_CHECK(static_wiring::instance<impl2>().get() ==
+        static_wiring::instance<impl2>().get());
+
+    static_wiring::injected<static_consumer> consumer;
+    BOOST_CHECK_EQUAL(consumer->s->id(), id_of<impl1>::id());
+    BOOST_CHECK(consumer->lazy_s.get() ==
+        static_wiring::instance<impl2>().get());
+}
+
+BOOST_AUTO_TEST_CASE(test_id_map)
+{
+    id_map<int> m;
+
+    // enough entries to grow the table a few times
+    for (unique_id i = 0 ; i < 1000 ; ++i) {
+        m[i * 7] = (int)i;
+    }
+
+    BOOST_CHECK_EQUAL(m.size(), 1000u);
+    BOOST_CHECK(m.find(1) == 0);
+    BOOST_CHECK(m.find(7 * 1000) == 0);
+
+    for (unique_id i = 0 ; i < 1000 ; ++i) {
+        BOOST_REQUIRE(m.find(i * 7) != 0);
+        BOOST_CHECK_EQUAL(*m.find(i * 7), (int)i);
+    }
+
+    // erase every other entry, make sure the rest are still reachable
+    for (unique_id i = 0 ; i < 1000 ; i += 2) {
+        BOOST_CHECK(m.erase(i * 7));
+    }
+
+    BOOST_CHECK(!m.erase(0));
+    BOOST_CHECK_EQUAL(m.size(), 500u);
+
+    for (unique_id i = 0 ; i < 1000 ; ++i) {
+        if (i % 2 == 0) {
+            BOOST_CHECK(m.find(i * 7) == 0);
+        } else {
+            BOOST_REQUIRE(m.find(i * 7) != 0);
+            BOOST_CHECK_EQUAL(*m.find(i * 7), (int)i);
+        }
+    }
+
+    m.clear();
+    BOOST_CHECK(m.empty());
+    BOOST_CHECK(m.find(7) == 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()